@@ -4,20 +4,53 @@
 #include <limits>
 #include <sstream>
 #include <fstream>
-#include <regex>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <ctime>
+#include <csignal>
+#include <cerrno>
+#include <chrono>
+#include <random>
+#include <thread>
 #ifdef _WIN32
     #include <windows.h>
     #include <conio.h>
     #include <direct.h>
     #include <io.h>
+    #include <sys/locking.h>
     #define ACCESS _access
     #define MKDIR(dir) _mkdir(dir)
+    #define CHDIR _chdir
+    #define DUP _dup
+    #define DUP2 _dup2
+    #define NULL_DEVICE "NUL"
+    #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+        #define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+    #endif
 #else
     #include <termios.h>
     #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <sys/file.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <poll.h>
+    #include <fcntl.h>
     #include <unistd.h>
     #define ACCESS access
     #define MKDIR(dir) mkdir(dir, 0777)
+    #define CHDIR chdir
+    #define DUP dup
+    #define DUP2 dup2
+    #define NULL_DEVICE "/dev/null"
 #endif
 #define START_HOUR 9
 #define END_HOUR 17 // Operating hours from 9 AM to 5 PM
@@ -26,6 +59,42 @@
 #define TREATMENT_SLOT_DURATION 2
 #define DAYS_IN_WEEK 5 // Monday to Friday
 #define MAX_SLOTS_PER_DAY 8 // Total slots available (8 hours)
+#define MAX_SESSION_SLOTS 4 // Longest session a service may take, in slots
+#define DEFAULT_CONSULTATION_PRICE 60.0 // Consultation price of a service that does not set its own
+#define BOOKING_LOG_FILE "bookings.log" // Append-only log of bookings, refunds and schedule changes
+#define LOG_COMPACTION_THRESHOLD 200 // Log records before the log is folded into bookings.txt
+#define SCHEDULE_FILE_MAGIC "LXSC" // Tag at the start of every binary schedule file
+#define SCHEDULE_FILE_VERSION 3 // Layout version of binary schedule files (version 1 had no revision or holds, version 2 had 32-bit hold tokens)
+#define SCHEDULE_HOLD_ENTRIES 8 // Pending slot holds one schedule file can carry
+#define SLOT_HOLD_SECONDS 300 // How long a terminal may hold slots while the customer confirms and pays
+#define CALENDAR_HORIZON_WEEKS 52 // Weeks, counting the current one, that can be booked ahead
+#define CALENDAR_EPOCH_MONDAY 4 // Days from 1 January 1970 to Monday 5 January 1970, where calendar week 0 starts
+#define LEGACY_MONTH_START "2024-07-01" // Monday of July 2024, the only month older files numbered weeks within
+#define LEGACY_MONTH_WEEKS 5 // Weeks older files numbered from LEGACY_MONTH_START
+#define LEGACY_MONTH_DAYS 31 // Last date of that month
+#define SCHEDULE_DAY_WIDTH 19 // Width of each day's column in the schedule table
+#define SCHEDULE_CACHE_CAPACITY 1024 // Expert-weeks the schedule cache keeps before dropping the least recently used
+#define NEXT_AVAILABLE_RESULTS 5 // Candidates listed by the first-available search
+#define SERVICES_FILE "services.txt" // Service catalog: name,treatment price,consultation price,treatment slots,consultation slots,description
+#define EXPERTS_FILE "experts.txt" // Experts and their logins: name,username,password,years of experience,rating
+#define BOOKING_COUNTER_FILE "booking_counter.txt" // Highest booking ID reserved by any terminal
+#define BOOKING_ID_BLOCK_SIZE 50 // Booking IDs reserved per counter file update
+#define BOOKING_NUMBER_DIGITS 8 // Zero-padded digits after the 'B' of a booking number
+#define SERVER_SOCKET_PATH "booking.sock" // Default Unix socket of the headless booking server
+#define SERVER_BACKLOG 64 // Pending connections the server socket queues
+#define SERVER_MAX_REQUEST 4096 // Longest request line the server accepts
+#define IMPORT_MIN_CHUNK_BYTES (1 << 16) // Smallest share of an import file given its own parsing thread
+#define BENCH_BATCH 100 // Calls timed together when a single call is too short to time on its own
+#define SCREEN_BUFFER_RESERVE 65536 // Bytes reserved up front for composing one screen
+#define RECEIPT_SPOOL_DIR "spool" // Default directory receipts are queued in for printing
+#define SCREEN_FLUSH_THRESHOLD (1 << 20) // Buffered bytes at which a long table is written out early
+// Character classes used by the validators
+#define CHAR_DIGIT 1
+#define CHAR_UPPER 2
+#define CHAR_LOWER 4
+#define CHAR_WORD 8 // Letters, digits and '_'
+#define CHAR_SPECIAL 16 // !@#$%^&*
+#define ALL_SLOTS_MASK ((1 << MAX_SLOTS_PER_DAY) - 1) // Bitmask covering every slot in a day
 #define OPTION_WIDTH 7
 #define DESC_WIDTH 28
 // Color codes for console output
@@ -45,6 +114,20 @@ struct Customer {
     string password;
 };
 
+// Struct representing the customer directory loaded once from customers.txt
+struct CustomerDirectory {
+    vector<Customer> customers;           // Every registered customer (no fixed cap)
+    unordered_map<string, int> byEmail;   // Normalized email -> customer index
+    bool loaded = false;                  // Whether customers.txt has been read yet
+};
+
+// Struct representing the result of validating a batch of customer records
+struct ValidationSummary {
+    int total = 0;            // Records checked
+    int valid = 0;            // Records that passed every check
+    vector<int> invalidRows;  // 1-based rows that failed a check
+};
+
 // Enum to define different payment methods
 enum PaymentMethod {
     EWALLET,
@@ -56,36 +139,62 @@ enum PaymentMethod {
 // Enum to define the type of session 
 enum  SessionType { TREATMENT, CONSULTATION, UNAVAILABLE };
 
-// Struct representing a service offered by an expert
+// Struct representing a service in the catalog, with a price and length for each session type
 struct Service {
+    int id = -1;                  // Catalog ID, dense from 0
     string name;
     string description;
-    double price;
+    double treatmentPrice = 0.0;
+    double consultationPrice = DEFAULT_CONSULTATION_PRICE;
+    int treatmentDuration = TREATMENT_SLOT_DURATION;       // Slots a treatment takes
+    int consultationDuration = CONSULTATION_SLOT_DURATION; // Slots a consultation takes
+    bool offered = false;         // Listed for booking; false for services only named by old bookings
 };
 
-// Struct representing a timeslot in an expert's schedule
-struct TimeSlot {
-    bool isBooked; // Indicates if the slot is booked
-    string timeRange; // Time range of the slot (e.g. "9:00 - 10:00")
-    SessionType type; // Type of session (consultation or treatment)
+// Struct representing the service catalog loaded once from services.txt
+struct ServiceCatalog {
+    vector<Service> services;              // Services indexed by their ID
+    vector<int> offeredIds;                // Services customers can book, in menu order
+    unordered_map<string, int> idsByName;  // Trimmed service name -> ID
 };
 
 // Struct representing an expert with a name, schedule, and working hours
+// Each day's slots are held as bitmasks, bit N standing for slot N (START_HOUR + N)
 struct Expert {
     string name; // Expert's name
-    TimeSlot schedule[DAYS_IN_WEEK][MAX_SLOTS_PER_DAY]; // Weekly schedule
+    unsigned char bookedMask[DAYS_IN_WEEK];      // Bit set when the slot is booked
+    unsigned char treatmentMask[DAYS_IN_WEEK];   // Bit set when the slot type is treatment
+    unsigned char unavailableMask[DAYS_IN_WEEK]; // Bit set when the slot type is unavailable
     int hoursWorkedPerDay[DAYS_IN_WEEK]; // Hours worked per day
 
 };
 
+// Struct representing the slot state of one expert-week in compact form, with no name or other per-expert data
+struct ScheduleBlock {
+    unsigned char hoursWorked[DAYS_IN_WEEK];     // Hours worked per day
+    unsigned char bookedMask[DAYS_IN_WEEK];      // Bit set when the slot is booked
+    unsigned char treatmentMask[DAYS_IN_WEEK];   // Bit set when the slot type is treatment
+    unsigned char unavailableMask[DAYS_IN_WEEK]; // Bit set when the slot type is unavailable
+};
+
+// Struct representing an expert's schedule across many weeks
+// Only weeks with activity hold a block; a week that is missing is fully open
+struct SparseSchedule {
+    unordered_map<int, ScheduleBlock> weeks; // Calendar week -> slot state
+};
+
 // Struct representing a receipt generated after a booking
 struct Receipt {
     string bookingNumber;     // Unique booking number
     Customer customer;        // The customer who made the booking
-    Expert expert;            // The expert assigned for the booking
+    int expertId;             // Registry ID of the expert assigned for the booking
+    int week;                 // Calendar week (weeks since Monday 5 January 1970), -1 if unknown
+    int day;                  // Day of the week (0-4 for Mon-Fri), -1 if unknown
+    int slot;                 // First time slot booked, -1 if unknown
+    int duration;             // Slots the session takes
     SessionType sessionType;  // Type of session booked
-    string serviceName;       // Name of the service booked
-    string date;              // Date of the booking
+    int serviceId;            // Catalog ID of the service booked
+    string date;              // Date of the booking (YYYY-MM-DD)
     string timeSlot;          // Time of the booking
     PaymentMethod paymentMethod; // Payment method used
     double amountPaid;        // Amount paid for the booking
@@ -95,7 +204,7 @@ struct Receipt {
 struct Booking {
     string referenceNum;  // Unique reference number for the booking
     Customer customer;    // Customer making the booking
-    Expert expert;        // Expert assigned to the session
+    int expertId;         // Registry ID of the expert assigned to the session
     Service service;      // Service being booked
     SessionType treatment; // Type of treatment or consultation
     int weekNumber;       // Week number of the booking
@@ -103,6 +212,197 @@ struct Booking {
     int slot;             // Time slot booked
 };
 
+// Struct representing the in-memory booking store loaded once from bookings.txt
+struct BookingStore {
+    vector<Receipt> receipts;   // Every booking in file order (no row cap)
+    vector<bool> active;        // False once a booking has been refunded
+    unordered_map<string, int> byBookingNumber;          // Booking number -> receipt index
+    unordered_map<string, vector<int>> byCustomerEmail;  // Customer email -> receipt indexes
+    unordered_map<int, vector<int>> byExpertId;          // Expert registry ID -> receipt indexes
+    vector<Customer> bookedCustomers;                    // Customer slot -> customer as first booked
+    unordered_map<string, int> customerSlots;            // Customer email -> customer slot
+    vector<int> customerBookingCounts;                   // Customer slot -> active bookings
+    vector<vector<int>> expertCustomerCounts;            // Expert registry ID -> customer slot -> active bookings
+    int activeCount = 0;        // Number of bookings that are not refunded
+    int logRecords = 0;         // Records appended to the booking log since the last snapshot
+    long long logOffset = -1;   // Bytes of the booking log applied to the store, -1 before the log is first read
+    string logGeneration;       // Generation record the log started with when the store last read it
+    bool loaded = false;        // Whether bookings.txt has been read yet
+};
+
+// Struct representing the revenue and booking count of one report group
+struct ReportBucket {
+    double revenue = 0; // Amount paid across the group
+    int bookings = 0;   // Bookings in the group
+};
+
+// Struct representing sales totals aggregated in one pass over the booking store
+struct SalesReport {
+    double totalRevenue = 0;
+    int totalBookings = 0;
+    unordered_map<int, ReportBucket> byService;       // Service catalog ID -> totals
+    unordered_map<int, ReportBucket> byExpert;        // Expert registry ID -> totals
+    unordered_map<int, ReportBucket> byDate;          // Day number (days since 1 January 1970) -> totals
+    unordered_map<int, ReportBucket> bySessionType;   // SessionType -> totals
+    unordered_map<int, ReportBucket> byPaymentMethod; // PaymentMethod -> totals
+};
+
+// Struct representing the booking IDs reserved by this process
+// The current block is packed as (first ID << 32) | one past the last ID so it is read in one load
+struct BookingIdAllocator {
+    atomic<unsigned long long> next{ 0 };   // Next candidate ID; only ever grows
+    atomic<unsigned long long> block{ 0 };  // Packed range of reserved IDs
+    mutex refill;                           // Held while a new block is reserved from the counter file
+};
+
+// Struct representing the login and public details of an expert, loaded from experts.txt
+struct ExpertProfile {
+    string username;           // Staff login, empty if the expert cannot log in
+    string password;
+    int yearsOfExperience = 0;
+    double rating = 0.0;       // Out of 5
+};
+
+// Struct representing the registry of experts, built once and referenced by ID
+struct ExpertRegistry {
+    vector<Expert> experts;                // Experts indexed by their ID
+    vector<ExpertProfile> profiles;        // Login and details of each expert, by ID
+    unordered_map<string, int> idsByName;  // Expert name -> ID
+};
+
+// Struct representing the schedules used to find the next available slot
+// Only expert-weeks with something booked hold a block; every other week is fully open
+struct AvailabilityIndex {
+    vector<SparseSchedule> schedules;            // Booking horizon of each expert, by registry ID
+    unsigned char openStarts[MAX_SESSION_SLOTS]; // Session starts of a day with nothing booked, by length
+    int expertCount = 0;                      // Experts covered by the index
+    bool built = false;                       // Whether every schedule has been read into the index
+};
+
+// Struct representing one expert-week held in the schedule cache
+struct CachedSchedule {
+    long long key = 0;                       // expertWeekKey of the week
+    ScheduleBlock block;                     // Slot state as this terminal sees it
+    unsigned int revision = 0;               // Revision of the schedule file the block was read at
+    bool onDisk = false;                     // Whether the week had a schedule file when it was read
+};
+
+// Struct representing the least recently used cache of expert-week schedules
+// It only serves reads: every change is written through under the schedule file's lock, so other terminals see
+// booked and freed slots at once, and nothing is left to flush on exit. Refunds of one batch are still coalesced
+// into one locked write per expert-week by updateExpertSchedules
+struct ScheduleCache {
+    list<CachedSchedule> entries;                                   // Most recently used first
+    unordered_map<long long, list<CachedSchedule>::iterator> byKey; // expertWeekKey -> entry
+};
+
+// Struct representing an open slot found by the availability search
+struct SlotCandidate {
+    int expertId; // Registry ID of the expert
+    int week;     // Calendar week
+    int day;      // Day of the week (0-4 for Mon-Fri)
+    int slot;     // First time slot of the session
+};
+
+// Fixed on-disk layout of one expert-week in a binary schedule file (one bit per slot)
+struct ScheduleFileLayout {
+    char magic[4];                                  // SCHEDULE_FILE_MAGIC
+    unsigned char version;                          // SCHEDULE_FILE_VERSION
+    unsigned char days;                             // DAYS_IN_WEEK the file was written with
+    unsigned char slotsPerDay;                      // MAX_SLOTS_PER_DAY the file was written with
+    unsigned char reserved;
+    unsigned char hoursWorked[DAYS_IN_WEEK];        // Hours worked per day
+    unsigned char bookedMask[DAYS_IN_WEEK];         // Bit set when the slot is booked
+    unsigned char treatmentMask[DAYS_IN_WEEK];      // Bit set when the slot type is treatment
+    unsigned char unavailableMask[DAYS_IN_WEEK];    // Bit set when the slot type is unavailable
+    // Version 1 files end here
+    unsigned int revision;                          // Bumped on every committed change to the week
+    struct {
+        unsigned long long token;                   // Terminal holding the slots, 0 when the entry is free
+        unsigned char day;                          // Day of the week the hold is on
+        unsigned char mask;                         // Slots held on that day
+        unsigned char reserved[6];
+        long long expiresAt;                        // Unix time the hold lapses
+    } holds[SCHEDULE_HOLD_ENTRIES];                 // Slots reserved by terminals that have not committed yet
+};
+
+// Size of a version 1 schedule file, which holds only the header and slot masks
+const size_t SCHEDULE_FILE_V1_SIZE = offsetof(ScheduleFileLayout, revision);
+
+// Struct representing a short-lived hold on slots, taken before payment and committed afterwards
+struct SlotHold {
+    unsigned long long token = 0; // Identifies this hold inside the schedule file
+    int expertId = -1;       // Registry ID of the expert
+    int week = -1;           // Calendar week
+    int day = -1;            // Day of the week (0-4 for Mon-Fri)
+    int slot = -1;           // First time slot held
+    SessionType sessionType = CONSULTATION;
+    int duration = CONSULTATION_SLOT_DURATION; // Slots held
+    unsigned int revision = 0; // Schedule revision the hold was placed against
+};
+
+// Struct representing a schedule file mapped into memory
+struct MappedFile {
+    char* data = nullptr;  // Start of the mapped bytes
+    size_t size = 0;       // Length of the mapping
+    bool writable = false; // Whether the mapping was opened for writing
+    bool discard = false;  // Remove the file when it is unmapped, because the week it holds is empty
+    string path;           // File that is mapped
+#ifdef _WIN32
+    string buffer;         // In-memory copy used instead of a mapping
+    HANDLE handle = INVALID_HANDLE_VALUE; // Open file holding the lock while the copy is in use
+#else
+    int fd = -1;           // Descriptor backing the mapping
+#endif
+};
+
+// Struct representing the fixed parts of the schedule table, built once and reused by every render
+struct ScheduleFrame {
+    string border;                              // Horizontal rule above and below the table
+    string timeHeader;                          // Border and the time column that open every week's header
+    string slotLabels[MAX_SLOTS_PER_DAY];       // Index and time range that open each slot row
+    string openCell;                            // Status cells, colored and centered in a day's column
+    string bookedCell;
+    string unavailableCell;
+};
+
+// Enum to define where printed receipts are sent
+enum ReceiptSinkType { RECEIPT_TO_FILE, RECEIPT_TO_SPOOL, RECEIPT_TO_STDOUT };
+
+// Struct representing the receipt sink chosen on the command line
+struct ReceiptSink {
+    ReceiptSinkType type = RECEIPT_TO_FILE;    // Keep only the receipts/ copy by default
+    string spoolDirectory = RECEIPT_SPOOL_DIR; // Directory a print spooler watches
+};
+
+// Struct representing one connection to the headless booking server
+struct ServerClient {
+    int fd = -1;            // Connected socket
+    string input;           // Bytes received but not yet split into request lines
+    string output;          // Responses waiting to be written
+    int customerIndex = -1; // Directory index of the logged-in customer, -1 until LOGIN or SIGNUP
+    bool closing = false;   // Close once the pending output has been written
+};
+
+// Struct representing the size of a synthetic dataset for the benchmark or the data generator
+struct DatasetConfig {
+    long long customers = 1000;       // Customers registered
+    int experts = 10;                 // Benchmark: experts added to the built-in ones; generator: experts in total
+    int weeks = CALENDAR_HORIZON_WEEKS; // Weeks, from the current one, bookings are spread over
+    long long bookings = 1000;        // Bookings made
+    unsigned int seed = 42;           // Seed for every random choice
+    string directory;                 // Empty directory the dataset is written to
+};
+
+// Struct representing one row of a bulk booking import
+struct ImportRow {
+    long long line = 0;   // Line number in the import file
+    size_t offset = 0;    // Where the row's text starts in the file
+    size_t length = 0;    // Length of the row's text
+    Receipt receipt;      // Booking the row describes, numbered once it is accepted
+    string error;         // Why the row was rejected, empty while it is accepted
+};
+
 // Enum to define types of users (admin or expert)
 enum UserType { ADMIN, EXPERT };
 
@@ -116,77 +416,238 @@ struct User {
 void displayLogo();
 void displayMainMenu();
 void customerManagement();
-void loadCustomersFromFile(Customer[], int&);
-void saveCustomersToFile(Customer[], int);
+void loadCustomersFromFile(CustomerDirectory&);
+void saveCustomerToFile(const Customer&);
+CustomerDirectory& getCustomerDirectory();
+string normalizeEmail(const string&);
+int findCustomerByEmail(const CustomerDirectory&, const string&);
+bool addCustomerToDirectory(CustomerDirectory&, const Customer&);
 void customerMenu(Customer&);
-void customerSignUp(Customer[], int &customerCount);
-int customerLogin(Customer[], int);
+void customerSignUp(CustomerDirectory&);
+int customerLogin(const CustomerDirectory&);
+string trim(const string&);
 bool isValidName(const string&);
 bool isValidEmail(const string&);
 bool isValidPassword(const string&);
 bool isValidPhoneNumber(const string&);
 bool isValidBankAccountNumber(const string&);
 bool isValidCreditCard(const string&, const string&);
+const unsigned char* validatorCharClasses();
+void trimBounds(const string&, size_t&, size_t&);
+bool matchesClassRun(const string&, size_t, size_t, unsigned char, size_t, size_t);
+ValidationSummary validateCustomerRecords(const vector<Customer>&);
 string generateOTP();
 bool verifyOTP(const string&);
 bool handlePaymentMethod(PaymentMethod);
 void initializeExpert(Expert&, const string&);
-void initializeService(Service&, string, double);
+ExpertRegistry& getExpertRegistry();
+void loadExpertsFromFile(ExpertRegistry&);
+bool saveExpertsToFile(const ExpertRegistry&);
+int registerExpert(const string&);
+int findExpertId(const string&);
+const Expert& getExpert(int);
+const string& getExpertName(int);
+const string& slotTimeRange(int);
+int daysFromCivil(int, int, int);
+void civilFromDays(int, int&, int&, int&);
+int currentDayNumber();
+int calendarWeekOf(int);
+int weekStartDay(int);
+int firstBookableWeek();
+bool isBookableDate(int, int);
+int storedWeekToCalendarWeek(int);
+int parseIsoDate(const string&);
+string isoDate(int);
+string formatDate(int);
+string formatShortDate(int);
+string formatWeekRange(int);
+string bookingDateText(const Receipt&);
+long long expertWeekKey(int, int);
+unsigned char slotRunMask(int, int);
+bool isSlotBooked(const Expert&, int, int);
+SessionType getSlotType(const Expert&, int, int);
+void bookSlots(Expert&, int, int, int, SessionType);
+void freeSlots(Expert&, int, int, int);
+ServiceCatalog& getServiceCatalog();
+void loadServicesFromFile(ServiceCatalog&);
+bool saveServicesToFile(const ServiceCatalog&);
+int internService(const string&);
+int findServiceId(const string&);
+const Service& getService(int);
+const vector<int>& getOfferedServices();
+void offerService(ServiceCatalog&, int);
+double servicePrice(const Service&, SessionType);
+int serviceDuration(const Service&, SessionType);
 string paymentMethodToString(PaymentMethod);
-void displayExpertDetails(Expert&);
+void displayExpertDetails(int);
 void generateReceipt(const Receipt&);
-void saveBooking(const Receipt&);
-int loadBookings(Receipt[]);
-void saveUpdatedReceipts(Receipt[], int);
+void appendReceipt(string&, const Receipt&);
+bool saveBooking(const Receipt&);
+int loadBookings(vector<Receipt>&);
+bool saveUpdatedReceipts(const BookingStore&);
+string formatBookingRecord(const Receipt&, const string&);
+bool parseBookingRecord(const string&, Receipt&);
+bool appendBookingLog(const string&);
+bool appendBookingLogRecords(const vector<string>&);
+bool writeBookingLogRecords(BookingStore&, FILE*, const vector<string>&);
+bool replayBookingLog(BookingStore&, FILE*);
+void loadBookingStore(BookingStore&, FILE*);
+void syncBookingStore(BookingStore&, FILE*);
+FILE* lockBookingLog();
+void unlockBookingLog(FILE*);
+bool truncateBookingLog(FILE*, long long);
+void compactBookingLog(BookingStore&, bool);
+bool updateScheduleFile(Expert&, int, const function<bool(Expert&, ScheduleFileLayout*)>&);
+void packScheduleBlock(const Expert&, ScheduleBlock&);
+void unpackScheduleBlock(const ScheduleBlock&, Expert&);
+bool isEmptyScheduleBlock(const ScheduleBlock&);
+void loadScheduleWeek(const SparseSchedule&, int, Expert&);
+void storeScheduleWeek(SparseSchedule&, int, const Expert&);
+bool hasActiveHolds(const ScheduleFileLayout*);
+void readScheduleLayout(const ScheduleFileLayout*, Expert&);
+void writeScheduleLayout(const Expert&, ScheduleFileLayout*);
+void purgeExpiredHolds(ScheduleFileLayout*, long long);
+unsigned char heldSlots(const ScheduleFileLayout*, int, unsigned long long);
+unsigned long long newHoldToken();
+bool placeSlotHold(Expert&, int, int, int, SessionType, int, SlotHold&);
+bool commitSlotHold(Expert&, const SlotHold&);
+void releaseSlotHold(const SlotHold&);
+BookingStore& getBookingStore();
+BookingStore& refreshBookingStore();
+void addBookingToStore(BookingStore&, const Receipt&);
+bool removeBookingFromStore(BookingStore&, const string&);
+const Receipt* findBookingByNumber(const string&);
+const vector<int>& findBookingsByEmail(const string&);
+const vector<int>& findBookingsByExpert(const string&);
 void displayCustomerBookings(Customer customer);
 void displayBookingInfo(Receipt);
 void generateSalesReport();
+void addToSalesReport(SalesReport&, const Receipt&);
+SalesReport aggregateSales(const BookingStore&);
+void displayReportBreakdown(string&, const string&, const string&, const unordered_map<int, ReportBucket>&, const vector<pair<int, string>>&);
 void displayCalendar(Expert&);
 void displaySchedule(const Expert&, int);
-bool canBookSlot(const Expert&, int, int, SessionType);
-void displayCustomers(const Customer[], int, int[]);
+string& getScreenBuffer();
+void flushScreen(string&);
+void appendPadded(string&, const string&, size_t, bool);
+void appendMoney(string&, double, int);
+const ScheduleFrame& getScheduleFrame();
+bool canBookSlot(const Expert&, int, int, int);
+void displayCustomers(const Customer[], const vector<int>&, const int[]);
 void displayCustomerDetails(Customer);
-void sortCustomersByName(Customer[], int, int[]);
-void sortCustomersByExpertBookings(Customer[], int, const Receipt[], int, const string&, int[]);
-void sortCustomersByTotalBookings(Customer[], int, int[]);
-int countCustomerExpertBookings(const Receipt[], int, const string&, const string&);
-void processRefund(Receipt&, Receipt[], int&);
-void updateExpertSchedule(Receipt&, Expert&);
+void sortCustomersByName(const Customer[], vector<int>&);
+void sortCustomersByBookings(vector<int>&, const int[]);
+void adjustCustomerBookingCounts(BookingStore&, const Receipt&, int);
+void processRefund(Receipt&);
+int processRefunds(const vector<Receipt>&);
+void updateExpertSchedules(const vector<Receipt>&);
+bool parseReceiptSlot(const string&, const string&, int&, int&, int&);
 int chooseWeek();
-int* selectTimeSlot(const Expert&, int, SessionType);
+int* selectTimeSlot(const Expert&, int, int);
 void saveScheduleToFile(const Expert&, int);
 void loadScheduleFromFile(Expert&, int);
+bool readScheduleFile(Expert&, int);
+int peekScheduleRevision(const string&, unsigned int&);
+ScheduleCache& getScheduleCache();
+CachedSchedule* findCachedSchedule(long long);
+CachedSchedule& cacheSchedule(long long, Expert&, unsigned int, bool);
+unsigned char freeRunStarts(unsigned char, int, int);
+AvailabilityIndex& getAvailabilityIndex();
+void buildAvailabilityIndex();
+void updateAvailabilityIndex(const Expert&, int);
+vector<SlotCandidate> findNextAvailableSlots(int, int);
+void bookFirstAvailable(Service, SessionType, Customer&);
+bool loadScheduleFromTextFile(Expert&, int);
+string scheduleFileName(const string&, int);
+string legacyScheduleFileName(const string&, int, const string&);
+bool mapScheduleFile(const string&, bool, MappedFile&);
+void unmapScheduleFile(MappedFile&);
 PaymentMethod selectPaymentMethod();
-int loadBookingCounter(const string&);
-void saveBookingCounter(const string&, int);
+bool reserveBookingIds(const string&, long long, long long&);
+BookingIdAllocator& getBookingIdAllocator();
+long long allocateBookingId();
 string generateBookingNumber();
 void generateReceiptFile(const Receipt&, const string&);
-void printReceipt(const string&);
+ReceiptSink& getReceiptSink();
+bool parseReceiptSink(const string&, ReceiptSink&);
+void printReceipt(const Receipt&, const string&);
 void makeBooking(Expert&, Service, SessionType, Customer&);
-void adminExpertMenu(UserType&, string&);
-void viewExpertSchedule(const string&);
+void confirmBooking(Expert&, int, int, int, Service, SessionType, Customer&);
+void adminExpertMenu(UserType&, int&);
+void viewExpertSchedule(int);
 void initializeCleanSchedule(Expert&);
 void viewAllShedules();
 void aboutUs();
-void viewCustomers(string);
+void viewCustomers(int);
 int getValidatedInput(int min, int max);
-bool adminExpertLogin(UserType&, string&);
+bool adminExpertLogin(UserType&, int&);
 string getPasswordInput();
 void serviceDesc(Service, Customer&);
 void viewServices(Customer&);
 void viewExperts();
 void checkSchedule();
+int displayExpertTable();
 void viewBookedSchedule();
 void pauseAndClearInput();
 void pauseAndClear();
 void clearScreen();
+Receipt buildReceipt(const string&, const Customer&, const Expert&, int, int, int, const Service&, SessionType, PaymentMethod, double);
+vector<string> splitRequestFields(const string&);
+string handleServerRequest(ServerClient&, const string&);
+int runBookingServer(const string&);
+bool parseDatasetConfig(int, char*[], DatasetConfig&);
+bool enterEmptyDataDirectory(const string&);
+Customer syntheticCustomer(long long);
+void reportBenchmark(const string&, vector<double>&, double);
+int silenceStdout();
+void restoreStdout(int);
+int runBenchmark(const DatasetConfig&);
+int generateDataset(const DatasetConfig&);
+bool parseImportRow(const string&, ImportRow&);
+long long parseImportChunk(const string&, size_t, size_t, vector<ImportRow>&);
+int importBookings(const string&, const string&);
+
+
+
+int main(int argc, char* argv[]) {
+    // Receipt sink option, accepted ahead of any mode
+    if (argc >= 2 && string(argv[1]).compare(0, 11, "--receipts=") == 0) {
+        if (!parseReceiptSink(string(argv[1]).substr(11), getReceiptSink())) {
+            cerr << "Usage: latest [--receipts=file|stdout|spool[:DIR]] [--server|--bench|--generate|--import ...]" << endl;
+            return 1;
+        }
+        --argc;
+        ++argv;
+    }
+    // Headless mode: serve the booking operations over a Unix socket instead of the menus
+    if (argc >= 2 && string(argv[1]) == "--server") {
+        return runBookingServer(argc >= 3 ? argv[2] : SERVER_SOCKET_PATH);
+    }
+    // Benchmark mode: time the booking path against a synthetic dataset
+    if (argc >= 2 && string(argv[1]) == "--bench") {
+        DatasetConfig config;
+        config.directory = "bench_data";
+        return parseDatasetConfig(argc, argv, config) ? runBenchmark(config) : 1;
+    }
+    // Import mode: book the rows of a CSV file from another system in one batch
+    if (argc >= 2 && string(argv[1]) == "--import") {
+        if (argc < 3) {
+            cerr << "Usage: latest --import FILE [REJECTS]" << endl;
+            return 1;
+        }
+        return importBookings(argv[2], argc >= 4 ? argv[3] : string(argv[2]) + ".rejects");
+    }
+    // Generator mode: write customers, bookings and matching schedules for sizing tests
+    if (argc >= 2 && string(argv[1]) == "--generate") {
+        DatasetConfig config;
+        config.directory = "generated_data";
+        config.bookings = 5000;
+        return parseDatasetConfig(argc, argv, config) ? generateDataset(config) : 1;
+    }
 
-
-
-int main() {
     int choice;
     UserType userType;
-    string userName;
+    int expertId = -1; // Registry ID of the logged-in expert
 
     do {
         displayLogo(); // Display the system logo
@@ -199,8 +660,8 @@ int main() {
             customerManagement(); // Customer management section
             break;
         case 2:
-            if (adminExpertLogin(userType, userName)) {  // Login as admin or expert
-                adminExpertMenu(userType, userName);     // Show the admin/expert menu
+            if (adminExpertLogin(userType, expertId)) {  // Login as admin or expert
+                adminExpertMenu(userType, expertId);     // Show the admin/expert menu
             }
             break;
         case 3:
@@ -239,14 +700,347 @@ void displayMainMenu() {
 // Function to initialize an expert's schedule
 void initializeExpert(Expert& expert, const string& name) {
     expert.name = name;
-    for (int day = 0; day < DAYS_IN_WEEK; ++day) {
-        expert.hoursWorkedPerDay[day] = 0;
-        for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
-            expert.schedule[day][slot].isBooked = false;
-            expert.schedule[day][slot].timeRange = to_string(START_HOUR + slot) + ":00 - " + to_string(START_HOUR + slot + 1) + ":00";
-            expert.schedule[day][slot].type = CONSULTATION; // Default to consultation
+    initializeCleanSchedule(expert);
+}
+
+// Function to get the expert registry, loading experts.txt on first use only
+ExpertRegistry& getExpertRegistry() {
+    static ExpertRegistry registry;
+    static bool loaded = false;
+    if (!loaded) {
+        loaded = true; // Set first so registerExpert can reach the registry while loading
+        loadExpertsFromFile(registry);
+    }
+    return registry;
+}
+
+// Function to load the experts and their profiles from experts.txt, writing the default team if it is missing
+void loadExpertsFromFile(ExpertRegistry& registry) {
+    ifstream inFile(EXPERTS_FILE);
+    if (!inFile) {
+        // First run: start with the original team and save it so more experts can be added to the file
+        const struct { const char* name; const char* username; const char* password; int years; double rating; } defaults[] = {
+            { "Alice", "alice123", "Alice1234$", 5, 4.9 },
+            { "Bob", "bob123", "Bob1234$", 2, 4.7 },
+            { "Carol", "carol123", "Carol1234$", 8, 4.8 },
+        };
+        for (const auto& entry : defaults) {
+            int id = registerExpert(entry.name);
+            registry.profiles[id] = { entry.username, entry.password, entry.years, entry.rating };
+        }
+        saveExpertsToFile(registry);
+        return;
+    }
+
+    string line;
+    // Read each line: name,username,password,years of experience,rating
+    while (getline(inFile, line)) {
+        if (trim(line).empty()) {
+            continue; // Skip empty lines
+        }
+        stringstream ss(line); // For splitting the line
+        string name, years, rating;
+        ExpertProfile profile;
+        getline(ss, name, ',');
+        getline(ss, profile.username, ',');
+        getline(ss, profile.password, ',');
+        getline(ss, years, ',');
+        getline(ss, rating, ',');
+        if (trim(name).empty()) {
+            continue;
+        }
+        profile.username = trim(profile.username);
+        profile.yearsOfExperience = atoi(years.c_str());
+        profile.rating = atof(rating.c_str());
+        registry.profiles[registerExpert(name)] = profile;
+    }
+    inFile.close();
+}
+
+// Function to write every registered expert and their profile to experts.txt
+bool saveExpertsToFile(const ExpertRegistry& registry) {
+    ofstream outFile(EXPERTS_FILE, ios::trunc);
+    if (!outFile) {
+        cerr << RED << "Error: Unable to write " << EXPERTS_FILE << RESET << endl;
+        return false;
+    }
+    for (size_t id = 0; id < registry.experts.size(); ++id) {
+        const ExpertProfile& profile = registry.profiles[id];
+        outFile << registry.experts[id].name << "," << profile.username << "," << profile.password << ","
+            << profile.yearsOfExperience << "," << fixed << setprecision(1) << profile.rating << "\n";
+    }
+    return static_cast<bool>(outFile);
+}
+
+// Function to get the ID of an expert, adding the expert to the registry if it is new
+int registerExpert(const string& name) {
+    ExpertRegistry& registry = getExpertRegistry();
+    string key = trim(name);
+    auto it = registry.idsByName.find(key);
+    if (it != registry.idsByName.end()) {
+        return it->second;
+    }
+    int id = static_cast<int>(registry.experts.size());
+    Expert expert;
+    initializeExpert(expert, key);
+    registry.experts.push_back(expert);
+    registry.profiles.push_back(ExpertProfile()); // No login until a profile is loaded for the expert
+    registry.idsByName[key] = id;
+    return id;
+}
+
+// Function to find the ID of an expert by name, -1 if there is no such expert
+int findExpertId(const string& name) {
+    ExpertRegistry& registry = getExpertRegistry();
+    auto it = registry.idsByName.find(trim(name));
+    return it == registry.idsByName.end() ? -1 : it->second;
+}
+
+// Function to get an expert from the registry by ID
+const Expert& getExpert(int expertId) {
+    return getExpertRegistry().experts[expertId];
+}
+
+// Function to get an expert's name by ID
+const string& getExpertName(int expertId) {
+    static const string unknown = "Unknown";
+    ExpertRegistry& registry = getExpertRegistry();
+    if (expertId < 0 || expertId >= static_cast<int>(registry.experts.size())) {
+        return unknown;
+    }
+    return registry.experts[expertId].name;
+}
+
+// Function to get the time range label of a slot (e.g. "9:00 - 10:00")
+const string& slotTimeRange(int slot) {
+    static string labels[MAX_SLOTS_PER_DAY];
+    if (labels[slot].empty()) {
+        labels[slot] = to_string(START_HOUR + slot) + ":00 - " + to_string(START_HOUR + slot + 1) + ":00";
+    }
+    return labels[slot];
+}
+
+// Function to count the days from 1 January 1970 to a date in the Gregorian calendar
+int daysFromCivil(int year, int month, int day) {
+    year -= month <= 2 ? 1 : 0; // Count years from March so the leap day falls at the end
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Function to turn a count of days from 1 January 1970 back into a year, month and day
+void civilFromDays(int days, int& year, int& month, int& day) {
+    days += 719468; // Shift the epoch to 1 March of year 0
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+// Function to get today's local date as days since 1 January 1970
+int currentDayNumber() {
+    time_t now = time(nullptr);
+    tm local = *localtime(&now);
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+// Function to get the calendar week (Monday to Sunday) a day falls in
+int calendarWeekOf(int dayNumber) {
+    int offset = dayNumber - CALENDAR_EPOCH_MONDAY;
+    return (offset >= 0 ? offset : offset - 6) / 7;
+}
+
+// Function to get the day number of the Monday a calendar week starts on
+int weekStartDay(int week) {
+    return week * 7 + CALENDAR_EPOCH_MONDAY;
+}
+
+// Function to get the calendar week the booking horizon starts at: the current week, or the next one at the weekend
+int firstBookableWeek() {
+    int today = currentDayNumber();
+    int week = calendarWeekOf(today);
+    return today - weekStartDay(week) >= DAYS_IN_WEEK ? week + 1 : week;
+}
+
+// Function to check whether a weekday can still be booked: not in the past and within the horizon
+bool isBookableDate(int week, int day) {
+    int firstWeek = firstBookableWeek();
+    return day >= 0 && day < DAYS_IN_WEEK && week >= firstWeek && week < firstWeek + CALENDAR_HORIZON_WEEKS &&
+        weekStartDay(week) + day >= currentDayNumber();
+}
+
+// Function to map a week read from a stored record to a calendar week
+// Older records numbered the weeks of July 2024 from 0; calendar weeks of any later date are far larger
+int storedWeekToCalendarWeek(int week) {
+    static const int legacyFirstWeek = calendarWeekOf(parseIsoDate(LEGACY_MONTH_START));
+    return week >= 0 && week < LEGACY_MONTH_WEEKS ? legacyFirstWeek + week : week;
+}
+
+// Function to parse a YYYY-MM-DD date into days since 1 January 1970, -1 if it is not a valid date
+int parseIsoDate(const string& text) {
+    string date = trim(text);
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+        return -1;
+    }
+    // Read the digits directly; bulk imports parse a date on every row
+    int digits[8];
+    const int positions[8] = { 0, 1, 2, 3, 5, 6, 8, 9 };
+    for (int i = 0; i < 8; ++i) {
+        char c = date[positions[i]];
+        if (c < '0' || c > '9') {
+            return -1;
         }
+        digits[i] = c - '0';
+    }
+    int year = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3];
+    int month = digits[4] * 10 + digits[5];
+    int day = digits[6] * 10 + digits[7];
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return -1;
+    }
+    int dayNumber = daysFromCivil(year, month, day);
+    int checkYear, checkMonth, checkDay;
+    civilFromDays(dayNumber, checkYear, checkMonth, checkDay);
+    return checkMonth == month && checkDay == day ? dayNumber : -1; // Rejects dates such as 31 June
+}
+
+// Function to format a day number as YYYY-MM-DD, the form dates are stored in
+string isoDate(int dayNumber) {
+    int year, month, day;
+    civilFromDays(dayNumber, year, month, day);
+    char text[16];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d", year, month, day);
+    return text;
+}
+
+// Function to format a day number for display (e.g. "30 July 2024")
+string formatDate(int dayNumber) {
+    static const char* months[12] = { "January", "February", "March", "April", "May", "June",
+        "July", "August", "September", "October", "November", "December" };
+    int year, month, day;
+    civilFromDays(dayNumber, year, month, day);
+    return to_string(day) + " " + months[month - 1] + " " + to_string(year);
+}
+
+// Function to format a day number as a day and short month (e.g. "30 Jul")
+string formatShortDate(int dayNumber) {
+    static const char* months[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    int year, month, day;
+    civilFromDays(dayNumber, year, month, day);
+    return to_string(day) + " " + months[month - 1];
+}
+
+// Function to format the Monday to Friday range of a calendar week (e.g. "1 Jul - 5 Jul 2024")
+string formatWeekRange(int week) {
+    int firstYear, lastYear, month, day;
+    civilFromDays(weekStartDay(week), firstYear, month, day);
+    civilFromDays(weekStartDay(week) + DAYS_IN_WEEK - 1, lastYear, month, day);
+    return formatShortDate(weekStartDay(week)) + (firstYear != lastYear ? " " + to_string(firstYear) : "") + " - " +
+        formatShortDate(weekStartDay(week) + DAYS_IN_WEEK - 1) + " " + to_string(lastYear);
+}
+
+// Function to get the display date of a booking, falling back to the stored text when its week is unknown
+string bookingDateText(const Receipt& receipt) {
+    if (receipt.week < 0 || receipt.day < 0) {
+        return trim(receipt.date);
+    }
+    return formatDate(weekStartDay(receipt.week) + receipt.day);
+}
+
+// Function to build the key of an expert-week in per-week maps
+long long expertWeekKey(int expertId, int week) {
+    return (static_cast<long long>(expertId) << 32) | static_cast<unsigned int>(week);
+}
+
+// Function to build the mask of a run of slots starting at a slot
+unsigned char slotRunMask(int slot, int duration) {
+    return static_cast<unsigned char>(((1 << duration) - 1) << slot);
+}
+
+// Function to check whether a slot is booked
+bool isSlotBooked(const Expert& expert, int day, int slot) {
+    return (expert.bookedMask[day] >> slot) & 1;
+}
+
+// Function to get the session type a slot is set to
+SessionType getSlotType(const Expert& expert, int day, int slot) {
+    if ((expert.treatmentMask[day] >> slot) & 1) return TREATMENT;
+    if ((expert.unavailableMask[day] >> slot) & 1) return UNAVAILABLE;
+    return CONSULTATION;
+}
+
+// Function to mark a run of slots as booked for a session type
+void bookSlots(Expert& expert, int day, int slot, int duration, SessionType sessionType) {
+    unsigned char run = slotRunMask(slot, duration);
+    expert.bookedMask[day] |= run;
+    expert.unavailableMask[day] &= ~run;
+    if (sessionType == TREATMENT) expert.treatmentMask[day] |= run;
+    else expert.treatmentMask[day] &= ~run;
+    expert.hoursWorkedPerDay[day] += duration;
+}
+
+// Function to free a run of slots and reset them to consultation
+void freeSlots(Expert& expert, int day, int slot, int duration) {
+    unsigned char run = slotRunMask(slot, duration) & expert.bookedMask[day]; // Slots already free are left alone
+    expert.bookedMask[day] &= ~run;
+    expert.treatmentMask[day] &= ~run;
+    expert.unavailableMask[day] &= ~run;
+    for (unsigned char bits = run; bits != 0; bits &= bits - 1) {
+        expert.hoursWorkedPerDay[day]--; // One hour per slot freed
+    }
+}
+
+// Function to copy an expert's loaded week into a compact schedule block
+void packScheduleBlock(const Expert& expert, ScheduleBlock& block) {
+    for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+        block.hoursWorked[day] = static_cast<unsigned char>(expert.hoursWorkedPerDay[day]);
+    }
+    memcpy(block.bookedMask, expert.bookedMask, DAYS_IN_WEEK);
+    memcpy(block.treatmentMask, expert.treatmentMask, DAYS_IN_WEEK);
+    memcpy(block.unavailableMask, expert.unavailableMask, DAYS_IN_WEEK);
+}
+
+// Function to load a compact schedule block into an expert as its current week
+void unpackScheduleBlock(const ScheduleBlock& block, Expert& expert) {
+    for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+        expert.hoursWorkedPerDay[day] = block.hoursWorked[day];
+    }
+    memcpy(expert.bookedMask, block.bookedMask, DAYS_IN_WEEK);
+    memcpy(expert.treatmentMask, block.treatmentMask, DAYS_IN_WEEK);
+    memcpy(expert.unavailableMask, block.unavailableMask, DAYS_IN_WEEK);
+}
+
+// Function to check whether a schedule block is a fully open week, which never needs to be stored
+bool isEmptyScheduleBlock(const ScheduleBlock& block) {
+    static const ScheduleBlock empty = {};
+    return memcmp(&block, &empty, sizeof(ScheduleBlock)) == 0;
+}
+
+// Function to load one week of a sparse schedule into an expert, as a clean week when it holds no block
+void loadScheduleWeek(const SparseSchedule& schedule, int week, Expert& expert) {
+    auto it = schedule.weeks.find(week);
+    if (it == schedule.weeks.end()) {
+        initializeCleanSchedule(expert);
+        return;
     }
+    unpackScheduleBlock(it->second, expert);
+}
+
+// Function to store an expert's loaded week in a sparse schedule, dropping the block once the week is empty
+void storeScheduleWeek(SparseSchedule& schedule, int week, const Expert& expert) {
+    ScheduleBlock block;
+    packScheduleBlock(expert, block);
+    if (isEmptyScheduleBlock(block)) {
+        schedule.weeks.erase(week);
+        return;
+    }
+    schedule.weeks[week] = block;
 }
 
 // Converts the payment method enum to a string for display purposes
@@ -259,96 +1053,242 @@ string paymentMethodToString(PaymentMethod paymentMethod) {
     }
 }
 
-// Displays the expert's schedule for a specific week
-void displaySchedule(const Expert& expert, int week) {
+// Function to get the buffer a whole screen is composed in before it is written out
+string& getScreenBuffer() {
+    static string screen;
+    if (screen.capacity() < SCREEN_BUFFER_RESERVE) {
+        screen.reserve(SCREEN_BUFFER_RESERVE);
+    }
+    return screen;
+}
 
-    if (week < 0 || week >= 5) {
-        cout << RED << "Invalid week number. Please select a week from 1 to 5." << RESET << endl;
-        return;
+// Function to write a composed screen to the console in one call and empty the buffer
+void flushScreen(string& screen) {
+    cout.flush(); // Anything already sent through cout goes out first
+    fwrite(screen.data(), 1, screen.size(), stdout);
+    fflush(stdout);
+    screen.clear();
+}
+
+// Function to append text padded with spaces to a column width
+void appendPadded(string& out, const string& text, size_t width, bool alignRight) {
+    size_t fill = text.length() < width ? width - text.length() : 0;
+    if (alignRight) {
+        out.append(fill, ' ');
     }
+    out += text;
+    if (!alignRight) {
+        out.append(fill, ' ');
+    }
+}
 
-    const int DAYWIDTH = 19;  // Set the width for each day's column // Set the width for each slot
-    const string days[5] = { "Mon", "Tue", "Wed", "Thu", "Fri" }; // Days of the week
+// Function to append an amount with two decimals, right-aligned to a column width
+void appendMoney(string& out, double amount, int width) {
+    char text[64];
+    int length = snprintf(text, sizeof(text), "%*.2f", width, amount);
+    out.append(text, min(static_cast<size_t>(max(length, 0)), sizeof(text) - 1));
+}
 
-    int startDate = 1 + (week * 7); // Calculate the starting date for the selected week
-    int padding = (DAYWIDTH - 1 - days[0].length()) / 2; // Calculate padding for centering the day names
+// Function to get the parts of the schedule table that never change, built on first use
+const ScheduleFrame& getScheduleFrame() {
+    static ScheduleFrame frame;
+    if (!frame.border.empty()) {
+        return frame;
+    }
 
-    // Display the header for time and day names
-    cout << string(DAYWIDTH * 6 + 2, '-') << endl;
-    cout << "|" << setw(DAYWIDTH) << left << "Time";
+    const size_t DAYWIDTH = SCHEDULE_DAY_WIDTH;
+    frame.border = string(DAYWIDTH * 6 + 2, '-');
 
-    // Loop through each day to display its date
-    for (int i = 0; i < 5; ++i) {
-        int date = startDate + i;
-        string header;
-        if (date > 31) {
-            header = days[i] + " (Unavailable)"; // If date exceeds 31, mark as unavailable
-        }
-        else {
-            header = days[i] + " (" + to_string(date) + ")"; // Display day with the date
-        }
-        padding = (DAYWIDTH - header.length()) / 2;
-        cout << "|" << setw(padding) << "" << header << setw(DAYWIDTH - 1 - padding - header.length()) << "";
+    // Header rows open with the border and the time column; the dated day names follow per week
+    frame.timeHeader = frame.border + "\n|";
+    appendPadded(frame.timeHeader, "Time", DAYWIDTH, false);
+
+    // Index and time range at the start of every slot row
+    for (int i = 0; i < MAX_SLOTS_PER_DAY; ++i) {
+        string& label = frame.slotLabels[i];
+        label = "|" BLUE;
+        appendPadded(label, "[" + to_string(i + 1) + "]", 4, false);
+        label += RESET;
+        appendPadded(label, slotTimeRange(i), DAYWIDTH - 4, false);
     }
 
-    cout << "|" << endl;
-    cout << string(DAYWIDTH * 6 + 2, '-') << endl;
+    // One cell per slot status, centered in a day's column
+    auto cell = [DAYWIDTH](const char* color, const string& status) {
+        size_t padding = (DAYWIDTH - status.length()) / 2;
+        return "|" + string(color) + string(padding, ' ') + status + string(DAYWIDTH - 1 - padding - status.length(), ' ') + RESET;
+    };
+    frame.openCell = cell(GREEN, "Open");
+    frame.bookedCell = cell(RED, "Booked");
+    frame.unavailableCell = cell(RED, "Unavailable");
+    return frame;
+}
+
+// Displays the expert's schedule for a specific calendar week
+void displaySchedule(const Expert& expert, int week) {
+    static const string days[DAYS_IN_WEEK] = { "Mon", "Tue", "Wed", "Thu", "Fri" };
+
+    const ScheduleFrame& frame = getScheduleFrame();
+    string& screen = getScreenBuffer();
+    int startDay = weekStartDay(week); // Day number of the week's Monday
+    bool bookable[DAYS_IN_WEEK];
+
+    // Header with each day's date, centered in its column
+    screen += frame.timeHeader;
+    for (int i = 0; i < DAYS_IN_WEEK; ++i) {
+        string title = days[i] + " (" + formatShortDate(startDay + i) + ")";
+        size_t padding = (SCHEDULE_DAY_WIDTH - title.length()) / 2;
+        screen += "|";
+        screen.append(padding, ' ');
+        appendPadded(screen, title, SCHEDULE_DAY_WIDTH - 1 - padding, false);
+        bookable[i] = isBookableDate(week, i);
+    }
+    screen += "|\n" + frame.border + "\n";
 
-    // Loop through each slot to display its status for each day
+    // Loop through each slot to add its status for each day
     for (int i = 0; i < MAX_SLOTS_PER_DAY; i++) {
-        cout << "|" << BLUE << setw(4) << left << "[" + to_string(i + 1) + "]" << RESET // Align the index
-            << setw(DAYWIDTH - 4) << left << expert.schedule[0][i].timeRange; // Align the time range
+        screen += frame.slotLabels[i];
 
         // Loop through each day in the week
         for (int day = 0; day < DAYS_IN_WEEK; day++) {
-            int currentDate = startDate + day;
-
-            // Determine the status based on the date
-            if (currentDate > 31) {
-                // Beyond the last valid day, mark as "Unavailable"
-                padding = (DAYWIDTH - string("Unavailable").length()) / 2;
-                int rightPadding = DAYWIDTH - string("Unavailable").length() - padding - 1;
-                cout << "|" << RED << string(padding, ' ') << "Unavailable" << string(rightPadding, ' ') << RESET;
+            if (isSlotBooked(expert, day, i)) {
+                screen += frame.bookedCell;
             }
-            else if (expert.schedule[day][i].isBooked) {
-                // Slot is booked
-                padding = (DAYWIDTH - string("Booked").length()) / 2;
-                cout << "|" << RED << string(padding, ' ') << "Booked" << string(padding, ' ') << RESET;
+            else if (!bookable[day]) {
+                screen += frame.unavailableCell; // In the past or beyond the booking horizon
             }
             else if (expert.hoursWorkedPerDay[day] >= MAX_WORK_HOURS) {
-                // Slot is unavailable due to max hours worked
-                padding = (DAYWIDTH - string("Unavailable").length()) / 2;
-                int rightPadding = DAYWIDTH - string("Unavailable").length() - padding - 1;
-                cout << "|" << RED << string(padding, ' ') << "Unavailable" << string(rightPadding, ' ') << RESET;
+                screen += frame.unavailableCell; // Unavailable due to max hours worked
             }
             else {
-                // Slot is open
-                padding = (DAYWIDTH - string("Open").length()) / 2;
-                cout << "|" << GREEN << string(padding, ' ') << "Open" << string(padding, ' ') << RESET;
+                screen += frame.openCell;
             }
         }
-        // Display the bottom border of the schedule
-        cout << "|\n";
+        screen += "|\n";
     }
 
-    cout << string(DAYWIDTH * 6 + 2, '-') << "\n\n";
+    screen += frame.border;
+    screen += "\n\n";
+    flushScreen(screen);
 }
 
 
 
 // Checks if a slot can be booked based on availability and session duration
-bool canBookSlot(const Expert& expert, int day, int slot, SessionType sessionType) {
-    int duration = (sessionType == TREATMENT) ? TREATMENT_SLOT_DURATION : CONSULTATION_SLOT_DURATION;
+bool canBookSlot(const Expert& expert, int day, int slot, int duration) {
     if (expert.hoursWorkedPerDay[day] + duration > MAX_WORK_HOURS) {
         return false;  // Cannot book if it exceeds the max working hours
     }
-    // Ensure all required slots for the session are open
-    for (int i = 0; i < duration; ++i) {
-        if (slot + i >= MAX_SLOTS_PER_DAY || expert.schedule[day][slot + i].isBooked) {
-            return false;
+    if (slot + duration > MAX_SLOTS_PER_DAY) {
+        return false;  // Session would run past closing time
+    }
+    // Ensure all required slots for the session are open with a single mask test
+    return (expert.bookedMask[day] & slotRunMask(slot, duration)) == 0;
+}
+
+// Function to compute the slots where a session of the given length can start on a day
+unsigned char freeRunStarts(unsigned char bookedMask, int hoursWorked, int duration) {
+    if (hoursWorked + duration > MAX_WORK_HOURS) {
+        return 0;  // The session would exceed the expert's daily hours
+    }
+    unsigned char freeSlots = ~bookedMask & ALL_SLOTS_MASK;
+    unsigned char starts = freeSlots & (ALL_SLOTS_MASK >> (duration - 1)); // Must end before closing time
+    for (int i = 1; i < duration; ++i) {
+        starts &= freeSlots >> i; // Every following slot in the run must be free too
+    }
+    return starts;
+}
+
+// Function to get the availability index (built on the first search)
+AvailabilityIndex& getAvailabilityIndex() {
+    static AvailabilityIndex index;
+    return index;
+}
+
+// Function to read every expert's schedule once into the availability index
+// Only weeks in the booking horizon are read, and only weeks with a schedule file get a block
+void buildAvailabilityIndex() {
+    AvailabilityIndex& index = getAvailabilityIndex();
+    const vector<Expert>& experts = getExpertRegistry().experts;
+    index.expertCount = static_cast<int>(experts.size());
+    index.schedules.assign(index.expertCount, SparseSchedule());
+    for (int duration = 1; duration <= MAX_SESSION_SLOTS; ++duration) {
+        index.openStarts[duration - 1] = freeRunStarts(0, 0, duration);
+    }
+    index.built = true;
+    int firstWeek = firstBookableWeek();
+    for (int expertId = 0; expertId < index.expertCount; ++expertId) {
+        Expert expert = experts[expertId];
+        for (int week = firstWeek; week < firstWeek + CALENDAR_HORIZON_WEEKS; ++week) {
+            if (readScheduleFile(expert, week)) {
+                storeScheduleWeek(index.schedules[expertId], week, expert); // Weeks without a file are fully open
+            }
         }
     }
-    return true;
+}
+
+// Function to refresh one expert-week in the availability index after its schedule changes
+void updateAvailabilityIndex(const Expert& expert, int week) {
+    AvailabilityIndex& index = getAvailabilityIndex();
+    if (!index.built) {
+        return; // Nothing to keep current until the first search builds the index
+    }
+    int expertId = registerExpert(expert.name);
+    if (expertId >= index.expertCount) {
+        // A new expert joined after the index was built
+        index.expertCount = expertId + 1;
+        index.schedules.resize(index.expertCount);
+    }
+    storeScheduleWeek(index.schedules[expertId], week, expert);
+}
+
+// Function to find the earliest open slots for a session length across every expert and the booking horizon
+vector<SlotCandidate> findNextAvailableSlots(int duration, int count) {
+    AvailabilityIndex& index = getAvailabilityIndex();
+    if (duration < 1 || duration > MAX_SESSION_SLOTS) {
+        return {};
+    }
+    if (!index.built) {
+        buildAvailabilityIndex();
+    }
+    vector<SlotCandidate> candidates;
+    vector<const ScheduleBlock*> blocks(index.expertCount);
+    vector<unsigned char> starts(index.expertCount);
+
+    // Walk the calendar in time order and stop as soon as enough slots are found
+    int firstWeek = firstBookableWeek();
+    for (int week = firstWeek; week < firstWeek + CALENDAR_HORIZON_WEEKS; ++week) {
+        for (int expertId = 0; expertId < index.expertCount; ++expertId) {
+            const unordered_map<int, ScheduleBlock>& weeks = index.schedules[expertId].weeks;
+            auto it = weeks.find(week);
+            blocks[expertId] = it == weeks.end() ? nullptr : &it->second;
+        }
+        for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+            if (!isBookableDate(week, day)) {
+                continue;
+            }
+            unsigned char anyExpert = 0;
+            for (int expertId = 0; expertId < index.expertCount; ++expertId) {
+                const ScheduleBlock* block = blocks[expertId];
+                starts[expertId] = block == nullptr ? index.openStarts[duration - 1] :
+                    freeRunStarts(block->bookedMask[day], block->hoursWorked[day], duration);
+                anyExpert |= starts[expertId];
+            }
+            for (int slot = 0; anyExpert != 0 && slot < MAX_SLOTS_PER_DAY; ++slot) {
+                if (!((anyExpert >> slot) & 1)) {
+                    continue;
+                }
+                for (int expertId = 0; expertId < index.expertCount; ++expertId) {
+                    if ((starts[expertId] >> slot) & 1) {
+                        candidates.push_back({ expertId, week, day, slot });
+                        if (static_cast<int>(candidates.size()) == count) {
+                            return candidates;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return candidates;
 }
 
 // Trims leading and trailing spaces from a string
@@ -357,90 +1297,79 @@ string trim(const string& str) {
         return "";
     }
     size_t first = str.find_first_not_of(' ');
+    if (first == string::npos) {
+        return "";  // String holds only spaces
+    }
     size_t last = str.find_last_not_of(' ');
     return str.substr(first, (last - first + 1));  // Return trimmed string
 }
 
-// Prompts the user to select a valid week number for booking
+// Prompts the user to select a week of the booking horizon; returns its calendar week, or -1 to go back
 int chooseWeek() {
     int choice;
-    cout << "Enter week number (1-5, -999 to go back): ";
-    choice = getValidatedInput(1, 5);  // Get a validated input within the range
+    cout << "Enter week number (1-" << CALENDAR_HORIZON_WEEKS << ", -999 to go back): ";
+    choice = getValidatedInput(1, CALENDAR_HORIZON_WEEKS);  // Get a validated input within the range
     if (choice == -999) {
         return -1;  // Allow exit from the menu
     }
-    if (choice < 1 || choice > 5) {
+    if (choice < 1 || choice > CALENDAR_HORIZON_WEEKS) {
         cout << RED << "Invalid choice. Please select a valid week.\n" << RESET;
         return chooseWeek();  // Recursively prompt for a valid input
     }
-    return --choice;  // Convert 1-based week to 0-based index
+    return firstBookableWeek() + choice - 1;  // Week 1 is the current week
 }
 
-// Displays the available weeks and days in a calendar format
+// Displays the weeks of the booking horizon with the open slots the expert has in each
 void displayCalendar(Expert& expert) {
-
-    const int DAYWIDTH = 12;  // Width for each day's display
-    const string days[5] = { "Mon", "Tue", "Wed", "Thu", "Fri" };
-
-    // Display header for weeks
-    cout << "\nAvailable Weeks and Days:" << endl;
-
-    // Loop through each week and day
-    for (int week = 0; week < 5; ++week) {
-        loadScheduleFromFile(expert, week); // Load the expert's schedule for the given week
+    string& screen = getScreenBuffer();
+    int firstWeek = firstBookableWeek();
+
+    screen += "\nAvailable Weeks:\n";
+    screen += "+------+---------------------------+-----------------+\n";
+    screen += "| Week | Dates                     | Open Slots      |\n";
+    screen += "+------+---------------------------+-----------------+\n";
+
+    // Loop through each week; weeks without a schedule file have nothing booked
+    for (int week = firstWeek; week < firstWeek + CALENDAR_HORIZON_WEEKS; ++week) {
+        if (!readScheduleFile(expert, week)) {
+            initializeCleanSchedule(expert);
+        }
         int availableSlots = 0;
-        int startDate = 1 + (week * 7); // Calculate the starting date for the week
-        for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
-            for (int day = 0; day < 5; ++day) {
-                if (week == 4 && (startDate + day) > 31) break; // Skip slots after 31st
-                if (!expert.schedule[day][slot].isBooked && expert.schedule[day][slot].type != UNAVAILABLE) {
-                    availableSlots++; // Count available slots
-                }
+        for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+            if (!isBookableDate(week, day)) {
+                continue; // Skip days that have already passed
+            }
+            unsigned char taken = expert.bookedMask[day] | expert.unavailableMask[day];
+            for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
+                availableSlots += !((taken >> slot) & 1); // Count available slots
             }
         }
-        if (availableSlots > 0) {
-            cout << "Week " << (week + 1) << ":" << "(" << GREEN << availableSlots  << " slots available)" << RESET << endl;
-        } else {
-            cout << "Week " << (week + 1) << ":" << "(" << RED << 0  << " slots available)" << RESET << endl;
-        }
-
-        // Display days and dates for the week
-        cout << string(DAYWIDTH * 6 + 2, '-') << endl;
-        cout << "|" << setw(DAYWIDTH) << left << "Day";
-        for (int i = 0; i < 5; ++i) {
-            int date = startDate + i;
-            if (week == 4 && date > 31) break;  // Stop after the 31st
-            string header = days[i] + " (" + to_string(date) + ")";
-            cout << "|" << setw(DAYWIDTH - 1) << left << header;
+        screen += "| " BLUE;
+        appendPadded(screen, "[" + to_string(week - firstWeek + 1) + "]", 4, true);
+        screen += RESET " | ";
+        appendPadded(screen, formatWeekRange(week), 25, false);
+        screen += availableSlots > 0 ? " | " GREEN : " | " RED;
+        appendPadded(screen, to_string(availableSlots) + " available", 15, false);
+        screen += RESET " |\n";
+        if (screen.size() >= SCREEN_FLUSH_THRESHOLD) {
+            flushScreen(screen);
         }
-        cout << "|" << endl;
-        cout << string(DAYWIDTH * 6 + 2, '-') << "\n\n";
-
-        // Display the slots for each day
     }
+    screen += "+------+---------------------------+-----------------+\n\n";
+    flushScreen(screen);
 }
 
 // Function to select a time slot for booking
-int* selectTimeSlot(const Expert& expert, int chosenWeek, SessionType sessionType) {
+int* selectTimeSlot(const Expert& expert, int chosenWeek, int duration) {
     static int result[2]; // Array to store selected day and slot
     int selectedDay;
-    // Choose a day for the booking depending on the week number
-    if (chosenWeek != 4) {
-        cout << "Select a day (1-5 for Mon-Fri, -999 to go back): ";
-        selectedDay = getValidatedInput(1, 5); // Validate day input
-        if (selectedDay == -999) { // Return nullptr if user chooses to go back
-            return nullptr;
-        }
-        selectedDay -= 1; // Convert to 0-based index
-    }
-    else {
-        cout << "Select a day (1-3 for Mon-Wed, -999 to go back): ";
-        selectedDay = getValidatedInput(1, 3); // Validate day input
-        if (selectedDay == -999) { // Return nullptr if user chooses to go back
-            return nullptr;
-        }
-        selectedDay -= 1; // Convert to 0-based index
+    // Choose a day for the booking
+    cout << "Select a day (1-5 for Mon-Fri, -999 to go back): ";
+    selectedDay = getValidatedInput(1, DAYS_IN_WEEK); // Validate day input
+    if (selectedDay == -999) { // Return nullptr if user chooses to go back
+        return nullptr;
     }
+    selectedDay -= 1; // Convert to 0-based index
 
     cout << "Select a starting time slot (1-" << MAX_SLOTS_PER_DAY << ", -999 to go back): ";
     int selectedSlot = getValidatedInput(1, MAX_SLOTS_PER_DAY); // Validate time slot input
@@ -449,11 +1378,10 @@ int* selectTimeSlot(const Expert& expert, int chosenWeek, SessionType sessionTyp
     }
     selectedSlot -= 1; // Convert to 0-based index
 
-    // Validate the selected time slot based on availability and session type
-    if (chosenWeek >= 0 && chosenWeek < 5 &&
-        selectedDay >= 0 && selectedDay < DAYS_IN_WEEK &&
+    // Validate the selected time slot based on the date, availability and session type
+    if (isBookableDate(chosenWeek, selectedDay) &&
         selectedSlot >= 0 && selectedSlot < MAX_SLOTS_PER_DAY &&
-        canBookSlot(expert, selectedDay, selectedSlot, sessionType)) {
+        canBookSlot(expert, selectedDay, selectedSlot, duration)) {
         // Store selected day and slot in result
         result[0] = selectedDay;
         result[1] = selectedSlot;
@@ -461,224 +1389,606 @@ int* selectTimeSlot(const Expert& expert, int chosenWeek, SessionType sessionTyp
     }
 
     // Handle invalid selection
-    cout << RED << "Invalid selection, slot(s) already booked, or exceeds daily work limit." << RESET << endl;
+    cout << RED << "Invalid selection, date has passed, slot(s) already booked, or exceeds daily work limit." << RESET << endl;
     result[0] = -1;
     result[1] = -1;
     return result;
 }
 
-// Function to save a booking to the bookings file
-void saveBooking(const Receipt& receipt) {
-    // Open bookings.txt file in append mode
-    ofstream bookingsFile("bookings.txt", ios::app);
-    if (!bookingsFile.is_open()) {
-        cerr << RED << "Error: Unable to open bookings file for writing." << RESET << endl;
-        return;
-    }
-
-    // Write booking details to the file
-    bookingsFile << receipt.bookingNumber << ", "
-        << receipt.customer.name << ", "
-        << receipt.customer.email << ", "
-        << receipt.customer.contact << ", "
-        << receipt.expert.name << ", "
-        << receipt.serviceName << ", "
-        << static_cast<int>(receipt.sessionType) << ", "
-        << receipt.date << ", "
-        << receipt.timeSlot << ", "
-        << static_cast<int> (receipt.paymentMethod) << ", "
-        << receipt.amountPaid << "\n";
-
-    // Close the file after writing
-    bookingsFile.close();
+// Function to format a receipt as a comma-separated bookings record
+string formatBookingRecord(const Receipt& receipt, const string& separator) {
+    stringstream ss;
+    ss << receipt.bookingNumber << separator
+        << receipt.customer.name << separator
+        << receipt.customer.email << separator
+        << receipt.customer.contact << separator
+        << getExpertName(receipt.expertId) << separator
+        << getService(receipt.serviceId).name << separator
+        << static_cast<int>(receipt.sessionType) << separator
+        << receipt.date << separator
+        << receipt.timeSlot << separator
+        << static_cast<int> (receipt.paymentMethod) << separator
+        << receipt.amountPaid << separator
+        << receipt.week << separator
+        << receipt.day << separator
+        << receipt.slot << separator
+        << receipt.duration;
+    return ss.str();
 }
 
-// Function to load bookings from the bookings file
-int loadBookings(Receipt receipts[]) {
-    const int MAX_BOOKINGS = 200; // Maximum number of bookings to load
-    ifstream bookingsFile("bookings.txt");
-    if (!bookingsFile.is_open()) {
-        cerr << RED << "Error: Unable to open bookings file for reading." << RESET << endl;
-        return 0;
-    }
-    string line;
-    int count = 0;
+// Function to parse a comma-separated bookings record into a receipt
+bool parseBookingRecord(const string& line, Receipt& receipt) {
+    stringstream ss(line); // Parse the line into a stringstream
+    string item;
+    string row[15]; // Array to store fields in the line
 
-    // Read the bookings file line by line
-    while (getline(bookingsFile, line) && count < MAX_BOOKINGS) {
-        if (line.empty()) {
-            continue; // Skip empty lines
-        }
-        stringstream ss(line); // Parse the line into a stringstream
-        string item;
-        string row[11]; // Array to store fields in the line
+    int row_count = 0;
 
-        int row_count = 0;
+    // Split the line by commas and store each item in the row array
+    while (getline(ss, item, ',') && row_count < 15) {
 
-        // Split the line by commas and store each item in the row array
-        while (getline(ss, item, ',')) {
+        row[row_count] = item;
+        row_count++;
+    }
+    if (row_count < 11) {
+        return false; // Not enough fields for a booking
+    }
 
-            row[row_count] = item;
-            row_count++;
+    // Convert the numeric fields first, so a corrupt or torn record is rejected before it registers anything
+    int sessionType, paymentMethod;
+    double amountPaid;
+    int stored[4] = { -1, -1, -1, -1 }; // Week, day, first slot and duration
+    try {
+        sessionType = stoi(row[6]);
+        paymentMethod = stoi(row[9]);
+        amountPaid = stod(row[10]);
+        if (row_count == 15) {
+            for (int i = 0; i < 4; ++i) {
+                stored[i] = stoi(row[11 + i]);
+            }
         }
-
-        // Populate the receipts array with the parsed data
-        receipts[count].bookingNumber = row[0];
-        receipts[count].customer.name = row[1];
-        receipts[count].customer.email = row[2];
-        receipts[count].customer.contact = row[3];
-        receipts[count].expert.name = row[4];
-        receipts[count].serviceName = row[5];
-        receipts[count].sessionType = static_cast<SessionType> (stoi(row[6]));
-        receipts[count].date = row[7];
-        receipts[count].timeSlot = row[8];
-        receipts[count].paymentMethod = static_cast<PaymentMethod>(stoi(row[9]));
-        receipts[count].amountPaid = stod(row[10]);
-
-        count++; // Increment the booking count
+    }
+    catch (const exception&) {
+        return false; // Not a number where one is expected
+    }
+
+    // Populate the receipt with the parsed data
+    receipt.bookingNumber = row[0];
+    receipt.customer.name = row[1];
+    receipt.customer.email = row[2];
+    receipt.customer.contact = row[3];
+    receipt.expertId = registerExpert(row[4]);
+    receipt.serviceId = internService(row[5]);
+    receipt.sessionType = static_cast<SessionType>(sessionType);
+    receipt.date = row[7];
+    receipt.timeSlot = row[8];
+    receipt.paymentMethod = static_cast<PaymentMethod>(paymentMethod);
+    receipt.amountPaid = amountPaid;
+    if (row_count == 15) {
+        // Week, day, first slot and duration are stored with the booking
+        receipt.week = storedWeekToCalendarWeek(stored[0]);
+        receipt.day = stored[1];
+        receipt.slot = stored[2];
+        receipt.duration = stored[3];
+    }
+    else {
+        // Older records only carry the date and time slot text
+        receipt.duration = (receipt.sessionType == TREATMENT) ? TREATMENT_SLOT_DURATION : CONSULTATION_SLOT_DURATION;
+        if (parseReceiptSlot(receipt.date, receipt.timeSlot, receipt.week, receipt.day, receipt.slot)) {
+            receipt.week = storedWeekToCalendarWeek(receipt.week);
+        }
+        else {
+            receipt.week = receipt.day = receipt.slot = -1;
+        }
+    }
+    if (receipt.week >= 0 && receipt.day >= 0 && parseIsoDate(receipt.date) == -1) {
+        receipt.date = isoDate(weekStartDay(receipt.week) + receipt.day); // Older records stored only the date of July 2024
+    }
+    return true;
+}
+
+// Function to append records to the booking log in one write and flush them to disk
+bool appendBookingLogRecords(const vector<string>& records) {
+    if (records.empty()) {
+        return true;
+    }
+    BookingStore& store = getBookingStore(); // Load first; loading takes the log lock itself
+    FILE* logFile = lockBookingLog();
+    if (logFile == nullptr) {
+        cerr << RED << "Error: Unable to open booking log for writing." << RESET << endl;
+        return false;
+    }
+    syncBookingStore(store, logFile); // Apply what other terminals logged, so the store's log position stays exact
+    bool written = writeBookingLogRecords(store, logFile, records);
+    unlockBookingLog(logFile);
+    return written;
+}
+
+// Function to append records to the booking log and make them durable; the caller holds the log lock and has synced the store
+// A failed write is cut off again, so no partial record is left for a later replay
+bool writeBookingLogRecords(BookingStore& store, FILE* logFile, const vector<string>& records) {
+    string lines;
+    for (const string& record : records) {
+        lines += record + "\n";
+    }
+    bool written = fwrite(lines.data(), 1, lines.size(), logFile) == lines.size(); // One write per batch
+    written = fflush(logFile) == 0 && written;
+#ifndef _WIN32
+    written = fsync(fileno(logFile)) == 0 && written; // Make the records durable before reporting success
+#endif
+    if (!written) {
+        truncateBookingLog(logFile, max(store.logOffset, 0LL));
+        return false;
+    }
+    store.logRecords += static_cast<int>(records.size());
+    store.logOffset = max(store.logOffset, 0LL) + static_cast<long long>(lines.size());
+    return true;
+}
+
+// Function to open the booking log and take its exclusive lock
+// Appends, loading and compaction all hold it, so no terminal's records fall between a snapshot and a truncation
+FILE* lockBookingLog() {
+    FILE* logFile = fopen(BOOKING_LOG_FILE, "a+");
+    if (logFile == nullptr) {
+        return nullptr;
+    }
+#ifdef _WIN32
+    // Windows locks are mandatory, so lock a byte past any record and leave the log readable through other handles
+    fseek(logFile, 0x7FFFFFFF, SEEK_SET);
+    _locking(_fileno(logFile), _LK_LOCK, 1);
+#else
+    flock(fileno(logFile), LOCK_EX);
+#endif
+    return logFile;
+}
+
+// Function to release the booking log lock and close the log
+void unlockBookingLog(FILE* logFile) {
+#ifdef _WIN32
+    fseek(logFile, 0x7FFFFFFF, SEEK_SET);
+    _locking(_fileno(logFile), _LK_UNLCK, 1);
+#else
+    flock(fileno(logFile), LOCK_UN);
+#endif
+    fclose(logFile);
+}
+
+// Function to cut the locked booking log back to a length
+bool truncateBookingLog(FILE* logFile, long long length) {
+    fflush(logFile);
+#ifdef _WIN32
+    return _chsize(_fileno(logFile), static_cast<long>(length)) == 0;
+#else
+    return ftruncate(fileno(logFile), static_cast<off_t>(length)) == 0;
+#endif
+}
+
+// Function to append a single record to the booking log
+bool appendBookingLog(const string& record) {
+    return appendBookingLogRecords({ record });
+}
+
+// Function to save a booking by appending it to the booking log; false if it could not be logged
+bool saveBooking(const Receipt& receipt) {
+    BookingStore& store = getBookingStore(); // Make sure existing bookings are loaded before appending
+
+    // Write booking details to the log
+    if (!appendBookingLog("B " + formatBookingRecord(receipt, ", "))) {
+        cerr << RED << "Error: Unable to save booking " << receipt.bookingNumber << "." << RESET << endl;
+        return false;
+    }
+
+    addBookingToStore(store, receipt); // Keep the in-memory store and its indexes in sync
+    compactBookingLog(store, false);   // Fold the log into the snapshot once it grows large
+    return true;
+}
+
+// Function to load bookings from the bookings snapshot file
+int loadBookings(vector<Receipt>& receipts) {
+    ifstream bookingsFile("bookings.txt");
+    if (!bookingsFile.is_open()) {
+        return 0; // No snapshot has been written yet
+    }
+    string line;
+    int count = 0;
+
+    // Read the bookings file line by line
+    while (getline(bookingsFile, line)) {
+        if (line.empty()) {
+            continue; // Skip empty lines
+        }
+        Receipt receipt;
+        if (!parseBookingRecord(line, receipt)) {
+            cerr << RED << "Skipping malformed booking record: " << line << RESET << endl;
+            continue;
+        }
+        receipts.push_back(receipt);
+
+        count++; // Increment the booking count
     }
     // Close the file after reading
     bookingsFile.close();
     return count; // Return the number of bookings loaded
 }
 
-// Function to save updated receipts to the bookings file
-void saveUpdatedReceipts(Receipt allReceipts[], int receiptCount) {
-    ofstream file("bookings.txt"); // Open the bookings file for writing
+// Function to add a receipt to the booking store and its secondary indexes
+void addBookingToStore(BookingStore& store, const Receipt& receipt) {
+    int index = static_cast<int>(store.receipts.size());
+    store.receipts.push_back(receipt);
+    store.active.push_back(true);
+    store.byBookingNumber[trim(receipt.bookingNumber)] = index;
+    store.byCustomerEmail[trim(receipt.customer.email)].push_back(index);
+    store.byExpertId[receipt.expertId].push_back(index);
+    store.activeCount++;
+    adjustCustomerBookingCounts(store, receipt, 1);
+}
 
-    if (!file) { // Check if the file was opened successfully
-        cout << RED <<  "Error opening file for saving receipts." << RESET << endl;
-        return; // Exit the function if file opening fails
+// Function to mark a booking as refunded and drop it from the secondary indexes
+bool removeBookingFromStore(BookingStore& store, const string& bookingNumber) {
+    auto it = store.byBookingNumber.find(trim(bookingNumber));
+    if (it == store.byBookingNumber.end()) {
+        return false; // Booking not found
     }
+    int index = it->second;
+    const Receipt& receipt = store.receipts[index];
+
+    // Remove the receipt index from an index bucket
+    auto eraseFrom = [index](vector<int>& bucket) {
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            if (bucket[i] == index) {
+                bucket.erase(bucket.begin() + i);
+                return;
+            }
+        }
+    };
+    eraseFrom(store.byCustomerEmail[trim(receipt.customer.email)]);
+    eraseFrom(store.byExpertId[receipt.expertId]);
+    store.byBookingNumber.erase(it);
+    store.active[index] = false;
+    store.activeCount--;
+    adjustCustomerBookingCounts(store, receipt, -1);
+    return true;
+}
 
-    // Write updated receipt data back to the file
-    for (int i = 0; i < receiptCount; i++) {
-        // Write each field of the receipt into file
-        file << allReceipts[i].bookingNumber << ",";
-        file << allReceipts[i].customer.name << ",";
-        file << allReceipts[i].customer.email << ",";
-        file << allReceipts[i].customer.contact << ",";
-        file << allReceipts[i].expert.name << ",";
-        file << allReceipts[i].serviceName << ",";
-        file << allReceipts[i].sessionType << ",";
-        file << allReceipts[i].date << ",";
-        file << allReceipts[i].timeSlot << ",";
-        file << allReceipts[i].paymentMethod << ",";
-        file << allReceipts[i].amountPaid << "\n";
+// Function to keep the per-customer and per-customer-expert booking counts in step with a booking or refund
+void adjustCustomerBookingCounts(BookingStore& store, const Receipt& receipt, int delta) {
+    string email = trim(receipt.customer.email);
+    auto it = store.customerSlots.find(email);
+    int slot;
+    if (it == store.customerSlots.end()) {
+        slot = static_cast<int>(store.bookedCustomers.size());
+        store.customerSlots[email] = slot;
+        store.bookedCustomers.push_back(receipt.customer);
+        store.customerBookingCounts.push_back(0);
+    }
+    else {
+        slot = it->second;
     }
+    store.customerBookingCounts[slot] += delta;
 
-    file.close(); // Close the file after writing
+    if (receipt.expertId >= static_cast<int>(store.expertCustomerCounts.size())) {
+        store.expertCustomerCounts.resize(receipt.expertId + 1);
+    }
+    vector<int>& expertCounts = store.expertCustomerCounts[receipt.expertId];
+    if (slot >= static_cast<int>(expertCounts.size())) {
+        expertCounts.resize(store.bookedCustomers.size(), 0);
+    }
+    expertCounts[slot] += delta;
 }
 
-// Function to update an expert's schedule after a refund
-void updateExpertSchedule(Receipt& receipt, Expert& expert) {
-    int week = -1, receiptDay = -1, slot = -1;  // Initialize week, day, and slot variables
-    int date = stoi(trim(receipt.date));  // Convert date from string to integer
-    string timeSlot = trim(receipt.timeSlot);  // Trim whitespace from the time slot string
-    timeSlot = timeSlot.substr(0, timeSlot.find(' '));  // Extract the starting time from the time slot
+// Function to get the booking store, loading the snapshot and replaying the log on first use only
+BookingStore& getBookingStore() {
+    static BookingStore store;
+    if (!store.loaded) {
+        store.loaded = true;
+        FILE* logFile = lockBookingLog(); // Another terminal must not compact between the snapshot and the log being read
+        loadBookingStore(store, logFile);
+        if (logFile != nullptr) {
+            unlockBookingLog(logFile);
+        }
+        compactBookingLog(store, false);
+    }
+    return store;
+}
 
-    // Determine the week and day based on the date
-    if (date >= 1 && date <= 5) {
-        week = 0;
-        receiptDay = date - 1;
+// Function to get the booking store with the bookings and refunds of other terminals applied
+BookingStore& refreshBookingStore() {
+    BookingStore& store = getBookingStore();
+    FILE* logFile = lockBookingLog();
+    if (logFile != nullptr) {
+        syncBookingStore(store, logFile);
+        unlockBookingLog(logFile);
     }
-    else if (date >= 8 && date <= 12) {
-        week = 1;
-        receiptDay = date - 8;
+    return store;
+}
+
+// Function to fill a booking store from the bookings.txt snapshot and the booking log; the caller holds the log lock
+void loadBookingStore(BookingStore& store, FILE* logFile) {
+    vector<Receipt> receipts;
+    loadBookings(receipts);
+    store.receipts.reserve(receipts.size());
+    for (const Receipt& receipt : receipts) {
+        addBookingToStore(store, receipt);
     }
-    else if (date >= 15 && date <= 19) {
-        week = 2;
-        receiptDay = date - 15;
+    replayBookingLog(store, logFile);   // Recover bookings and refunds logged after the snapshot
+}
+
+// Function to bring a loaded booking store up to date with what other terminals logged; the caller holds the log lock
+// If another terminal compacted the log since, the new snapshot is read and its differences applied to the store
+void syncBookingStore(BookingStore& store, FILE* logFile) {
+    if (replayBookingLog(store, logFile)) {
+        return;
     }
-    else if (date >= 22 && date <= 26) {
-        week = 3;
-        receiptDay = date - 22;
+    BookingStore current;
+    current.loaded = true;
+    loadBookingStore(current, logFile);
+    for (size_t i = 0; i < store.receipts.size(); ++i) {
+        if (store.active[i] && current.byBookingNumber.count(trim(store.receipts[i].bookingNumber)) == 0) {
+            removeBookingFromStore(store, store.receipts[i].bookingNumber); // Refunded at another terminal
+        }
     }
-    else if (date >= 29 && date <= 31) {
-        week = 4;
-        receiptDay = date - 29;
+    for (size_t i = 0; i < current.receipts.size(); ++i) {
+        if (current.active[i] && store.byBookingNumber.count(trim(current.receipts[i].bookingNumber)) == 0) {
+            addBookingToStore(store, current.receipts[i]); // Booked at another terminal
+        }
     }
+    store.logRecords = current.logRecords;
+    store.logOffset = current.logOffset;
+    store.logGeneration = current.logGeneration;
+}
 
-    // Determine the time slot
-    if (timeSlot == "9:00") {
-        slot = 0;
+// Function to apply the booking log records a store has not read yet; the caller holds the log lock
+// Returns false, applying nothing, if the log was compacted into a new snapshot since the store last read it
+bool replayBookingLog(BookingStore& store, FILE* lockedLog) {
+    ifstream logFile(BOOKING_LOG_FILE, ios::binary);
+    string generation; // Compaction starts the log with a 'G' record, so a store can tell a compacted log from its own
+    if (!logFile.is_open() || !getline(logFile, generation) || generation.compare(0, 2, "G ") != 0) {
+        generation.clear();
+    }
+    if (store.logOffset >= 0 && generation != store.logGeneration) {
+        return false;
     }
-    else if (timeSlot == "10:00") {
-        slot = 1;
+    long long start = max(store.logOffset, 0LL);
+    if (!logFile.is_open()) {
+        store.logGeneration = generation;
+        store.logOffset = 0;
+        return true; // Nothing has been logged since the last snapshot
     }
-    else if (timeSlot == "11:00") {
-        slot = 2;
+    logFile.clear();
+    logFile.seekg(0, ios::end);
+    if (static_cast<long long>(logFile.tellg()) < start) {
+        return false; // Emptied by a compaction that could not start a new generation
     }
-    else if (timeSlot == "12:00") {
-        slot = 3;
+    store.logGeneration = generation;
+    logFile.seekg(start);
+    string contents((istreambuf_iterator<char>(logFile)), istreambuf_iterator<char>());
+    logFile.close();
+
+    // A record without its trailing newline was torn by a crash mid-write; drop it
+    size_t validLength = contents.rfind('\n') == string::npos ? 0 : contents.rfind('\n') + 1;
+    if (validLength < contents.size() && lockedLog != nullptr) {
+        cerr << YELLOW << "Discarding incomplete booking log record." << RESET << endl;
+        truncateBookingLog(lockedLog, start + static_cast<long long>(validLength));
     }
-    else if (timeSlot == "13:00") {
-        slot = 4;
+
+    size_t position = 0;
+    while (position < validLength) {
+        size_t lineEnd = contents.find('\n', position);
+        string line = contents.substr(position, lineEnd - position);
+        position = lineEnd + 1;
+        if (line.size() < 2 || line[0] == 'G') {
+            continue;
+        }
+        store.logRecords++;
+        string payload = line.substr(2);
+
+        if (line[0] == 'B') { // Booking record, skipped if the snapshot already holds it
+            Receipt receipt;
+            if (parseBookingRecord(payload, receipt) &&
+                store.byBookingNumber.find(trim(receipt.bookingNumber)) == store.byBookingNumber.end()) {
+                addBookingToStore(store, receipt);
+            }
+        }
+        else if (line[0] == 'R') { // Refund tombstone
+            removeBookingFromStore(store, payload);
+        }
+        // 'S' records, written by earlier versions, hold whole schedule days. They are not applied: schedule files are written durably under their own
+        // lock, and an older day state replayed over the file would free slots of bookings made since
     }
-    else if (timeSlot == "14:00") {
-        slot = 5;
+    store.logOffset = start + static_cast<long long>(validLength);
+    return true;
+}
+
+// Function to fold the booking log into a new bookings.txt snapshot
+void compactBookingLog(BookingStore& store, bool force) {
+    if (!force && store.logRecords < LOG_COMPACTION_THRESHOLD) {
+        return; // Log is still short enough to replay cheaply
     }
-    else if (timeSlot == "15:00") {
-        slot = 6;
+    FILE* logFile = lockBookingLog();
+    if (logFile == nullptr) {
+        return;
     }
-    else if (timeSlot == "16:00") {
-        slot = 7;
+    // Other terminals may have logged since this one last read the log; their records are applied to the store
+    // in place, so receipts and index lists already looked up are not swapped out from under their callers
+    syncBookingStore(store, logFile);
+    if (saveUpdatedReceipts(store)) {
+        // The snapshot now holds every logged booking and refund, and schedule files are already saved
+        // The emptied log starts with a new generation, so other terminals know to read the new snapshot
+        static mt19937_64 random(random_device{}());
+        string generation = "G " + to_string(random());
+        if (!truncateBookingLog(logFile, 0)) {
+            cerr << RED << "Error: Unable to truncate the booking log." << RESET << endl;
+        }
+        else {
+            store.logOffset = 0;
+            store.logGeneration = writeBookingLogRecords(store, logFile, { generation }) ? generation : "";
+        }
+        store.logRecords = 0;
     }
+    unlockBookingLog(logFile);
+}
 
-    // Ensure the slot, week, and day are valid
-    if (week != -1 && receiptDay != -1 && slot != -1) {
-        // Load the expert's schedule for the corresponding week
-        loadScheduleFromFile(expert, week);
+// Function to look up a booking by its booking number
+// The receipt lives in the store's receipt list, so copy it before booking anything else
+const Receipt* findBookingByNumber(const string& bookingNumber) {
+    BookingStore& store = getBookingStore();
+    auto it = store.byBookingNumber.find(trim(bookingNumber));
+    return it == store.byBookingNumber.end() ? nullptr : &store.receipts[it->second];
+}
 
-        // Mark the slot(s) as available (not booked) and adjust the expert's working hours
-        expert.schedule[receiptDay][slot].isBooked = false;
-        if (receipt.sessionType == TREATMENT) {
-            expert.schedule[receiptDay][slot + 1].isBooked = false;  // Unbook the next slot for treatment
-            expert.hoursWorkedPerDay[receiptDay] -= 2;  // Deduct 2 hours for a treatment session
-        }
-        else {
-            expert.hoursWorkedPerDay[receiptDay]--; // Deduct 1 hour for a consultation session
-        } 
+// Function to look up the receipt indexes of every booking made with an email
+const vector<int>& findBookingsByEmail(const string& email) {
+    static const vector<int> none;
+    BookingStore& store = getBookingStore();
+    auto it = store.byCustomerEmail.find(trim(email));
+    return it == store.byCustomerEmail.end() ? none : it->second;
+}
+
+// Function to look up the receipt indexes of every booking with an expert
+const vector<int>& findBookingsByExpert(const string& expertName) {
+    static const vector<int> none;
+    BookingStore& store = getBookingStore();
+    auto it = store.byExpertId.find(findExpertId(expertName));
+    return it == store.byExpertId.end() ? none : it->second;
+}
 
-        // Reset the slot type to consultation
-        expert.schedule[receiptDay][slot].type = CONSULTATION; // Default to consultation
+// Function to write the active receipts in the booking store to a new bookings snapshot
+bool saveUpdatedReceipts(const BookingStore& store) {
+    const string tempFile = "bookings.txt.tmp";
+    ofstream file(tempFile); // Write the snapshot beside the old one first
 
-        // Save the updated schedule back to the file
-        saveScheduleToFile(expert, week);
+    if (!file) { // Check if the file was opened successfully
+        cout << RED <<  "Error opening file for saving receipts." << RESET << endl;
+        return false; // Exit the function if file opening fails
     }
-    else {
-        // Output an error message if the week, day, or slot is invalid
-        cout << "Error: Invalid week, day, or time slot." << endl;
+
+    // Write updated receipt data back to the file
+    for (size_t i = 0; i < store.receipts.size(); i++) {
+        if (!store.active[i]) {
+            continue; // Refunded bookings are not written back
+        }
+        file << formatBookingRecord(store.receipts[i], ",") << "\n";
+    }
+
+    file.close(); // Close the file after writing
+    if (!file) {
+        return false;
     }
+#ifdef _WIN32
+    remove("bookings.txt"); // rename() does not replace existing files on Windows
+#endif
+    // Swap the new snapshot in so a crash never leaves a half-written bookings.txt
+    return rename(tempFile.c_str(), "bookings.txt") == 0;
 }
 
-// Function to process a refund for a booking
-void processRefund(Receipt& receipt, Receipt allReceipts[], int& receiptCount) {
-    cout << "Processing refund for Booking Number: " << receipt.bookingNumber << endl;
+// Function to work out the week of July 2024, day and slot of a legacy booking record from its date and time slot text
+bool parseReceiptSlot(const string& dateText, const string& timeSlotText, int& week, int& receiptDay, int& slot) {
+    week = -1, receiptDay = -1, slot = -1;  // Initialize week, day, and slot variables
+    string trimmedDate = trim(dateText);
+    string timeSlot = trim(timeSlotText);
+    size_t hourEnd = timeSlot.find(':');
+    if (trimmedDate.empty() || trimmedDate.size() > 2 || trimmedDate.find_first_not_of("0123456789") != string::npos ||
+        hourEnd == string::npos || hourEnd == 0 || hourEnd > 2 || timeSlot.find_first_not_of("0123456789") < hourEnd) {
+        return false;  // Not a day of the month and an "H:00" start time
+    }
 
-    // Find index of the receipt to remove
-    int receiptIndex = -1;
-    for (int i = 0; i < receiptCount; i++) {
-        if (allReceipts[i].bookingNumber == receipt.bookingNumber) {
-            receiptIndex = i;
-            break;
+    // Weeks start on the 1st, 8th, 15th, ...; only Monday to Friday can be booked
+    int date = stoi(trimmedDate);
+    int hour = stoi(timeSlot.substr(0, hourEnd));
+    if (date < 1 || date > LEGACY_MONTH_DAYS || (date - 1) % 7 >= DAYS_IN_WEEK ||
+        hour < START_HOUR || hour >= START_HOUR + MAX_SLOTS_PER_DAY) {
+        return false;
+    }
+    week = (date - 1) / 7;
+    receiptDay = (date - 1) % 7;
+    slot = hour - START_HOUR;
+    return true;
+}
+
+// Function to free the slots of refunded bookings in their experts' schedules
+void updateExpertSchedules(const vector<Receipt>& receipts) {
+    // Group the refunds by expert and week so each schedule file is read and written once
+    unordered_map<long long, vector<const Receipt*>> groups;
+    vector<long long> groupOrder;
+    for (const Receipt& receipt : receipts) {
+        if (receipt.week < 0 || receipt.day < 0 || receipt.day >= DAYS_IN_WEEK ||
+            receipt.slot < 0 || receipt.duration < 1 || receipt.slot + receipt.duration > MAX_SLOTS_PER_DAY) {
+            // Output an error message if the week, day, or slot is invalid
+            cout << "Error: Invalid week, day, or time slot for booking " << trim(receipt.bookingNumber) << "." << endl;
+            continue;
         }
+        long long key = expertWeekKey(receipt.expertId, receipt.week);
+        vector<const Receipt*>& group = groups[key];
+        if (group.empty()) {
+            groupOrder.push_back(key);
+        }
+        group.push_back(&receipt);
     }
 
-    if (receiptIndex == -1) { // If receipt not found
-        cout << RED << "Error: Booking not found." << RESET << endl;
-        return;
+    for (long long key : groupOrder) {
+        const vector<const Receipt*>& group = groups[key];
+        int week = group[0]->week;
+        Expert expert = getExpert(group[0]->expertId);  // Resolve the expert from the registry
+
+        // Free the slots against the week as it is on disk, so concurrent bookings on other slots are kept
+        updateScheduleFile(expert, week, [&](Expert& current, ScheduleFileLayout*) {
+            for (const Receipt* receipt : group) {
+                // Mark the slot(s) as available (not booked), reset them to consultation and adjust the expert's working hours
+                freeSlots(current, receipt->day, receipt->slot, receipt->duration);
+            }
+            return true;
+        });
     }
+}
 
-    // Shift all subsequent receipts to fill the gap left by the removed receipt
-    for (int i = receiptIndex; i < receiptCount - 1; i++) {
-        allReceipts[i] = allReceipts[i + 1];
+// Function to refund a batch of bookings; returns how many were found and refunded
+int processRefunds(const vector<Receipt>& receipts) {
+    BookingStore& store = getBookingStore();
+    FILE* logFile = lockBookingLog();
+    if (logFile == nullptr) {
+        cerr << RED << "Error: Unable to open booking log for writing." << RESET << endl;
+        return 0;
+    }
+    syncBookingStore(store, logFile); // Another terminal may have refunded some of these bookings already
+
+    vector<Receipt> refunded;
+    vector<string> tombstones;
+    unordered_set<string> seen;
+    for (const Receipt& receipt : receipts) {
+        string bookingNumber = trim(receipt.bookingNumber);
+        auto it = store.byBookingNumber.find(bookingNumber);
+        if (it != store.byBookingNumber.end() && seen.insert(bookingNumber).second) {
+            refunded.push_back(store.receipts[it->second]);
+            tombstones.push_back("R " + bookingNumber);  // Record the refund as a tombstone
+        }
+    }
+    // The refund counts once its tombstones are durable; only then are the store and schedules changed
+    bool logged = !refunded.empty() && writeBookingLogRecords(store, logFile, tombstones);
+    if (logged) {
+        for (const Receipt& receipt : refunded) {
+            removeBookingFromStore(store, receipt.bookingNumber);
+        }
+    }
+    unlockBookingLog(logFile);
+    if (!logged) {
+        if (!refunded.empty()) {
+            cerr << RED << "Error: Unable to log the refund; nothing was refunded." << RESET << endl;
+        }
+        return 0;
     }
+    updateExpertSchedules(refunded);  // Free the slots, one schedule write per expert-week
+    compactBookingLog(store, false);  // Fold the log into the snapshot once it grows large
+    return static_cast<int>(refunded.size());
+}
 
-    receiptCount--;  // Decrease the receipt count after removing the booking
-    saveUpdatedReceipts(allReceipts, receiptCount);  // Save the updated receipts
-    updateExpertSchedule(receipt, receipt.expert);  // Update the expert's schedule
+// Function to refund a single booking from the menus
+void processRefund(Receipt& receipt) {
+    cout << "Processing refund for Booking Number: " << receipt.bookingNumber << endl;
 
+    if (processRefunds({ receipt }) == 0) { // If receipt not found or the refund could not be logged
+        cout << RED << "Error: Booking not found or not refunded." << RESET << endl;
+        return;
+    }
     cout << "Refund has been processed successfully." << endl; // Output a success message
 
 }
@@ -691,10 +2001,10 @@ void displayBookingInfo(Receipt receipt) {
 
     // Display each detail of the booking in a formatted manner
     cout << left << setw(20) << "Booking Number:" << receipt.bookingNumber << endl;
-    cout << left << setw(20) << "Service:" << trim(receipt.serviceName) << endl;
-    cout << left << setw(20) << "Expert:" << trim(receipt.expert.name) << endl;
+    cout << left << setw(20) << "Service:" << getService(receipt.serviceId).name << endl;
+    cout << left << setw(20) << "Expert:" << getExpertName(receipt.expertId) << endl;
     cout << left << setw(20) << "Customer Email:" << trim(receipt.customer.email) << endl;
-    cout << left << setw(20) << "Booking Date:" << trim(receipt.date) << " July 2024" << endl;
+    cout << left << setw(20) << "Booking Date:" << bookingDateText(receipt) << endl;
     cout << left << setw(20) << "Time Slot:" << trim(receipt.timeSlot) << endl;
     cout << left << setw(20) << "Price: RM " << fixed << setprecision(2) << receipt.amountPaid << endl;
 
@@ -706,8 +2016,7 @@ void displayBookingInfo(Receipt receipt) {
 
 // Function to display all bookings for a specific customer
 void displayCustomerBookings(Customer customer) {
-    Receipt allReceipts[150]; // Array to hold all receipts
-    int receiptCount = loadBookings(allReceipts); // Load receipts from file
+    BookingStore& store = getBookingStore(); // Bookings are indexed by customer email
 
     cout << "********************************************\n";
     cout << "*           CUSTOMER BOOKING DETAILS       *\n";
@@ -716,19 +2025,14 @@ void displayCustomerBookings(Customer customer) {
     cout << "\n----------------------------------------------\n";
     cout << "Please arrive 10 minutes before your time slot.\n";
     cout << "----------------------------------------------\n";
-    Receipt customerReceipts[30]; // Store customer receipts, assuming a customer can book up to 30 times
-    int bookingCount = 0; // Counter for customer bookings
-
-    bool hasBookings = false; // Flag to check if the customer has bookings
-    for (int i = 0; i < receiptCount; ++i) {
-        // Check if the email matches to store customer bookings
-        if (trim(allReceipts[i].customer.email) == trim(customer.email)) {
-            hasBookings = true;
-            customerReceipts[bookingCount] = allReceipts[i]; // Store matching booking
-            bookingCount++; // Increment booking count
-
-        }
+    const vector<int>& customerBookings = findBookingsByEmail(customer.email); // Indexes of the customer's bookings
+    vector<Receipt> customerReceipts; // Store customer receipts
+    for (int index : customerBookings) {
+        customerReceipts.push_back(store.receipts[index]);
     }
+    int bookingCount = static_cast<int>(customerReceipts.size()); // Counter for customer bookings
+
+    bool hasBookings = bookingCount > 0; // Flag to check if the customer has bookings
 
     if (hasBookings) { // If customer has bookings, display them
         int choice;
@@ -739,7 +2043,7 @@ void displayCustomerBookings(Customer customer) {
         // Display each booking in a formatted table
         for (int i = 0; i < bookingCount; ++i) {
             string sessionType = customerReceipts[i].sessionType == CONSULTATION ? " Consultation" : " Treatment";
-            string bookingInfo = customerReceipts[i].timeSlot + " " + customerReceipts[i].date + " July 2024 with" + customerReceipts[i].expert.name + " (" + trim(customerReceipts[i].serviceName) + sessionType + ")";
+            string bookingInfo = customerReceipts[i].timeSlot + " " + bookingDateText(customerReceipts[i]) + " with " + getExpertName(customerReceipts[i].expertId) + " (" + getService(customerReceipts[i].serviceId).name + sessionType + ")";
             cout << "| " << BLUE << "[" << setw(2) << i + 1 << "]" << RESET << "  | " << setw(72) << left << bookingInfo << " |" << endl;
         }
         cout << "+------+---------------------------------------------------------------------------+" << endl;
@@ -759,7 +2063,7 @@ void displayCustomerBookings(Customer customer) {
         refundOption = cin.get(); // Get refund option
         cin.ignore(1000, '\n');
         if (tolower(refundOption) == 'r') {
-             processRefund(customerReceipts[choice - 1], allReceipts, receiptCount); // Process refund if requested
+             processRefund(customerReceipts[choice - 1]); // Process refund if requested
         }
     }
     else {
@@ -775,27 +2079,164 @@ void createDirectoryIfNotExists(const string& directoryName) {
     }
 }
 
-// Function to save the expert's schedule to a file
-void saveScheduleToFile(const Expert& expert, int weekNumber) {
-    createDirectoryIfNotExists("schedules"); // Ensure the schedules directory exists
-    string filename = "schedules/" + trim(expert.name) + "_week" + to_string(weekNumber + 1) + "_schedule.txt"; // Generate filename based on expert and week number
-    ofstream outSchedule(filename); // Open file for output
+// Function to build the binary schedule filename for an expert and calendar week, named by the week's Monday
+string scheduleFileName(const string& expertName, int weekNumber) {
+    return "schedules/" + trim(expertName) + "_" + isoDate(weekStartDay(weekNumber)) + ".sched";
+}
 
-    if (outSchedule.is_open()) { // Check if file opened successfully
-        // Write each day's schedule to the file
-        for (int day = 0; day < DAYS_IN_WEEK; ++day) {
-            outSchedule << "Day " << day + 1 << endl;
-            outSchedule << expert.hoursWorkedPerDay[day]; // Write hours worked for the day
+// Function to build the filename older builds used for a week of July 2024 ("_week1" to "_week5" plus a suffix)
+// Returns an empty name for any other week, which never had a legacy file
+string legacyScheduleFileName(const string& expertName, int weekNumber, const string& suffix) {
+    int weekOfMonth = weekNumber - storedWeekToCalendarWeek(0);
+    if (weekOfMonth < 0 || weekOfMonth >= LEGACY_MONTH_WEEKS) {
+        return "";
+    }
+    return "schedules/" + trim(expertName) + "_week" + to_string(weekOfMonth + 1) + suffix;
+}
 
-            // Write each time slot's booking status and type
-            for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
-                outSchedule << ' ' << expert.schedule[day][slot].isBooked; // Write booking status
-                outSchedule << ' ' << (expert.schedule[day][slot].type == TREATMENT ? "T" :
-                    (expert.schedule[day][slot].type == CONSULTATION ? "C" : "U")) << ' '; // Write type (Treatment/Consultation/Unavailable)
+// Function to map a schedule file into memory under a file lock (exclusive when writable, shared otherwise)
+// Writable mappings create or extend the file to the current layout; read-only ones also accept version 1 files
+bool mapScheduleFile(const string& filename, bool writable, MappedFile& mapped) {
+    mapped.data = nullptr;
+    mapped.size = sizeof(ScheduleFileLayout);
+    mapped.writable = writable;
+    mapped.discard = false;
+    mapped.path = filename;
+#ifdef _WIN32
+    // Windows builds read the whole (tiny) file into a buffer instead of mapping it, holding the file's lock until
+    // the buffer is written back. Windows locks are mandatory, so like the booking log the lock is on a byte past
+    // any data, which leaves the header readable for the unlocked revision checks
+    OVERLAPPED lockRange = {};
+    lockRange.Offset = 0x7FFFFFFF;
+    for (int attempt = 0; ; ++attempt) {
+        mapped.handle = CreateFileA(filename.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0),
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mapped.handle == INVALID_HANDLE_VALUE) {
+            if (writable && GetLastError() == ERROR_ACCESS_DENIED && attempt < 1000) {
+                Sleep(1); // A removed file stays in the way until every handle to it is closed
+                continue;
             }
-            outSchedule << endl; // New line for next day
+            return false;
+        }
+        if (!LockFileEx(mapped.handle, writable ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0, &lockRange)) {
+            CloseHandle(mapped.handle);
+            return false;
+        }
+        BY_HANDLE_FILE_INFORMATION info;
+        bool removed = !GetFileInformationByHandle(mapped.handle, &info) || info.nNumberOfLinks == 0 ||
+            GetFileAttributesA(filename.c_str()) == INVALID_FILE_ATTRIBUTES;
+        if (!writable || !removed) {
+            break;
+        }
+        // The week was emptied and its file removed while this writer waited for the lock; start a new file
+        UnlockFileEx(mapped.handle, 0, 1, 0, &lockRange);
+        CloseHandle(mapped.handle);
+    }
+    mapped.buffer.assign(mapped.size, 0);
+    DWORD bytesRead = 0;
+    if (!ReadFile(mapped.handle, &mapped.buffer[0], static_cast<DWORD>(mapped.size), &bytesRead, nullptr) ||
+        (!writable && bytesRead < SCHEDULE_FILE_V1_SIZE)) {
+        UnlockFileEx(mapped.handle, 0, 1, 0, &lockRange);
+        CloseHandle(mapped.handle);
+        return false;
+    }
+    mapped.data = &mapped.buffer[0];
+    return true;
+#else
+    struct stat info;
+    while (true) {
+        mapped.fd = open(filename.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0666);
+        if (mapped.fd < 0) {
+            return false;
+        }
+        if (flock(mapped.fd, writable ? LOCK_EX : LOCK_SH) != 0 || fstat(mapped.fd, &info) != 0) {
+            close(mapped.fd);
+            return false;
+        }
+        if (!writable || info.st_nlink > 0) {
+            break;
+        }
+        // The week was emptied and its file removed while this writer waited for the lock; start a new file
+        close(mapped.fd);
+    }
+    if ((!writable && info.st_size < static_cast<off_t>(SCHEDULE_FILE_V1_SIZE)) ||
+        (writable && info.st_size != static_cast<off_t>(mapped.size) && ftruncate(mapped.fd, mapped.size) != 0)) {
+        close(mapped.fd); // Closing also drops the lock
+        return false;
+    }
+    if (!writable && info.st_size < static_cast<off_t>(mapped.size)) {
+        mapped.size = static_cast<size_t>(info.st_size); // Older, shorter layout
+    }
+    void* address = mmap(nullptr, mapped.size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, mapped.fd, 0);
+    if (address == MAP_FAILED) {
+        close(mapped.fd);
+        return false;
+    }
+    mapped.data = static_cast<char*>(address);
+    return true;
+#endif
+}
+
+// Function to flush and unmap a mapped schedule file, releasing its lock
+void unmapScheduleFile(MappedFile& mapped) {
+    if (mapped.data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    if (mapped.writable) {
+        // Written back even when discarded, so the empty week is on disk if the file cannot be removed yet
+        DWORD written = 0;
+        SetFilePointer(mapped.handle, 0, nullptr, FILE_BEGIN);
+        WriteFile(mapped.handle, mapped.data, static_cast<DWORD>(mapped.size), &written, nullptr);
+        SetEndOfFile(mapped.handle);
+        FlushFileBuffers(mapped.handle);
+    }
+    if (mapped.discard) {
+        remove(mapped.path.c_str()); // Still under the lock; writers already waiting see the file was removed
+    }
+    OVERLAPPED lockRange = {};
+    lockRange.Offset = 0x7FFFFFFF;
+    UnlockFileEx(mapped.handle, 0, 1, 0, &lockRange);
+    CloseHandle(mapped.handle);
+    mapped.handle = INVALID_HANDLE_VALUE;
+#else
+    if (mapped.writable) {
+        msync(mapped.data, mapped.size, MS_SYNC); // Push the written page back to the file
+    }
+    if (mapped.discard) {
+        unlink(mapped.path.c_str()); // Still under the lock; readers already waiting see the empty week written above
+    }
+    munmap(mapped.data, mapped.size);
+    flock(mapped.fd, LOCK_UN);
+    close(mapped.fd);
+#endif
+    mapped.data = nullptr;
+}
+
+// Function to save the expert's schedule to a binary schedule file, keeping any pending holds
+void saveScheduleToFile(const Expert& expert, int weekNumber) {
+    createDirectoryIfNotExists("schedules"); // Ensure the schedules directory exists
+    string filename = scheduleFileName(expert.name, weekNumber); // Generate filename based on expert and week number
+    MappedFile mapped;
+
+    if (mapScheduleFile(filename, true, mapped)) { // Check if file mapped successfully
+        ScheduleFileLayout* layout = reinterpret_cast<ScheduleFileLayout*>(mapped.data);
+        if (memcmp(layout->magic, SCHEDULE_FILE_MAGIC, 4) != 0 || layout->version != SCHEDULE_FILE_VERSION) {
+            memset(&layout->holds, 0, sizeof(layout->holds)); // Holds of an older layout cannot be kept
+        }
+        ScheduleBlock block;
+        packScheduleBlock(expert, block);
+        writeScheduleLayout(expert, layout);
+        mapped.discard = isEmptyScheduleBlock(block) && !hasActiveHolds(layout); // Only weeks with activity are kept on disk
+        unsigned int revision = layout->revision;
+        unmapScheduleFile(mapped); // Flush and unmap after writing
+        int expertId = findExpertId(expert.name);
+        if (expertId != -1) {
+            Expert saved = expert;
+            cacheSchedule(expertWeekKey(expertId, weekNumber), saved, revision, !mapped.discard);
         }
-        outSchedule.close(); // Close file after writing
+        updateAvailabilityIndex(expert, weekNumber); // Keep the next-available search current
     }
     else {
         // Error handling if file fails to open
@@ -803,59 +2244,415 @@ void saveScheduleToFile(const Expert& expert, int weekNumber) {
     }
 }
 
-// Function to load an expert's schedule from a file
+// Function to load an expert's schedule, starting a clean one when the week has no file
+// Weeks with nothing booked are never written, so a missing file is the usual state of a future week
 void loadScheduleFromFile(Expert& expert, int weekNumber) {
-    // Construct the filename for the schedule based on the expert's name and week number
-    string filename = "schedules/" + trim(expert.name) + "_week" + to_string(weekNumber + 1) + "_schedule.txt";
-    ifstream scheduleFile(filename); // Open the schedule file for reading
-
-    if (scheduleFile.is_open()) {
-        string line;
-        int week = -1; // Variable to track the current week (not used)
-        int day = -1; // Variable to track the current day
+    if (!readScheduleFile(expert, weekNumber)) {
+        initializeCleanSchedule(expert);
+    }
+}
 
-        // Read the file line by line
-        while (getline(scheduleFile, line)) {
-            // Check for lines indicating a new day
-            if (line.find("Day") == 0) {
-                day = stoi(line.substr(4)) - 1; // Extract day number
-                continue; // Move to the next line
-            }
-            if (day >= 0) {
-                stringstream ss(line); // Create a string stream to parse the line
-                int hoursWorked;
-                // Attempt to read hours worked, handle errors if parsing fails
-                if (!(ss >> hoursWorked)) {
-                    cerr << RED << "Error parsing hoursWorked: " << line << RESET << endl;
-                    continue; // Skip to the next line
-                }
-                expert.hoursWorkedPerDay[day] = hoursWorked; // Store hours worked for the day
+// Function to read an expert's schedule from the mapped binary file in place, false if there is no file
+// A week already in the schedule cache is served from memory while its file is still at the cached revision
+bool readScheduleFile(Expert& expert, int weekNumber) {
+    string filename = scheduleFileName(expert.name, weekNumber);
+    int expertId = findExpertId(expert.name);
+    long long key = expertWeekKey(expertId, weekNumber);
+    CachedSchedule* cached = expertId == -1 ? nullptr : findCachedSchedule(key);
+    if (cached != nullptr) {
+        unsigned int revision = 0;
+        int state = peekScheduleRevision(filename, revision);
+        if (cached->onDisk ? (state == 1 && revision == cached->revision) : state == 0) {
+            unpackScheduleBlock(cached->block, expert);
+            return cached->onDisk;
+        }
+    }
+    MappedFile mapped;
 
-                // Read the schedule for each time slot of the day
-                for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
-                    char isBooked, typeChar;
-                    // Attempt to read booking status and type, handle errors if parsing fails
-                    if (!(ss >> isBooked >> typeChar)) {
-                        cerr << RED << "Error reading slot data for Week " << week + 1 << " Day " << day + 1 << " from line: " << line << RESET << endl;
-                        break; // Break out of the loop if there's an error
-                    }
-                    // Set booking status based on the read data
-                    expert.schedule[day][slot].isBooked = (isBooked == '1');
-                    // Determine the type of session based on the character read
-                    if (typeChar == 'T') expert.schedule[day][slot].type = TREATMENT;
-                    else if (typeChar == 'C') expert.schedule[day][slot].type = CONSULTATION;
-                    else expert.schedule[day][slot].type = UNAVAILABLE;
-                }
-            }
+    if (!mapScheduleFile(filename, false, mapped)) {
+        // A binary file of July 2024 numbered by week of the month takes its dated name
+        string legacyBinary = legacyScheduleFileName(expert.name, weekNumber, ".sched");
+        if (!legacyBinary.empty() && rename(legacyBinary.c_str(), filename.c_str()) == 0) {
+            return readScheduleFile(expert, weekNumber);
         }
-        scheduleFile.close(); // Close the schedule file after reading
+        // Migrate a legacy text schedule once, then serve it from the binary file
+        if (loadScheduleFromTextFile(expert, weekNumber)) {
+            saveScheduleToFile(expert, weekNumber);
+            remove(legacyScheduleFileName(expert.name, weekNumber, "_schedule.txt").c_str());
+            return true;
+        }
+        if (expertId != -1) {
+            // Remember that the week has no file, so the next read costs a single failed open
+            Expert clean = expert;
+            initializeCleanSchedule(clean);
+            cacheSchedule(key, clean, 0, false);
+        }
+        return false;
     }
-    else {
-        // If the file doesn't exist, initialize a clean schedule
-        cout << "No existing schedule found for " << expert.name << ". Starting with a clean schedule." << endl;
+
+    const ScheduleFileLayout* layout = reinterpret_cast<const ScheduleFileLayout*>(mapped.data);
+    if (memcmp(layout->magic, SCHEDULE_FILE_MAGIC, 4) != 0 || layout->version < 1 || layout->version > SCHEDULE_FILE_VERSION ||
+        layout->days != DAYS_IN_WEEK || layout->slotsPerDay != MAX_SLOTS_PER_DAY) {
+        cerr << RED << "Unrecognised schedule file format: " << filename << RESET << endl;
+        unmapScheduleFile(mapped);
         initializeCleanSchedule(expert);
+        return true;
     }
-}
+
+    readScheduleLayout(layout, expert);
+    bool cacheable = expertId != -1 && layout->version >= 2; // Version 1 files have no revision to check
+    unsigned int revision = cacheable ? layout->revision : 0;
+    unmapScheduleFile(mapped); // Release the mapping after reading
+    if (cacheable) {
+        cacheSchedule(key, expert, revision, true);
+    }
+    return true;
+}
+
+// Function to read the revision of a schedule file without mapping or locking it
+// Returns 0 if there is no file, 1 with the revision set, or -1 if the file has no revision to compare
+int peekScheduleRevision(const string& filename, unsigned int& revision) {
+    ScheduleFileLayout header;
+    size_t wanted = offsetof(ScheduleFileLayout, holds); // Header, slot masks and revision
+#ifdef _WIN32
+    ifstream in(filename, ios::binary);
+    if (!in.is_open()) {
+        return 0;
+    }
+    in.read(reinterpret_cast<char*>(&header), wanted);
+    bool complete = in.gcount() == static_cast<streamsize>(wanted);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    bool complete = pread(fd, &header, wanted, 0) == static_cast<ssize_t>(wanted);
+    close(fd);
+#endif
+    if (!complete || memcmp(header.magic, SCHEDULE_FILE_MAGIC, 4) != 0 || header.version < 2 || header.version > SCHEDULE_FILE_VERSION) {
+        return -1;
+    }
+    revision = header.revision;
+    return 1;
+}
+
+// Function to get the schedule cache shared by every schedule read and write
+ScheduleCache& getScheduleCache() {
+    static ScheduleCache cache;
+    return cache;
+}
+
+// Function to look up an expert-week in the schedule cache and mark it most recently used, null if it is not cached
+CachedSchedule* findCachedSchedule(long long key) {
+    ScheduleCache& cache = getScheduleCache();
+    auto found = cache.byKey.find(key);
+    if (found == cache.byKey.end()) {
+        return nullptr;
+    }
+    cache.entries.splice(cache.entries.begin(), cache.entries, found->second);
+    return &*found->second;
+}
+
+// Function to store an expert-week as read from its file in the schedule cache
+CachedSchedule& cacheSchedule(long long key, Expert& expert, unsigned int revision, bool onDisk) {
+    ScheduleCache& cache = getScheduleCache();
+    CachedSchedule* entry = findCachedSchedule(key);
+    if (entry == nullptr) {
+        cache.entries.emplace_front();
+        entry = &cache.entries.front();
+        entry->key = key;
+        cache.byKey[key] = cache.entries.begin();
+    }
+    packScheduleBlock(expert, entry->block);
+    entry->revision = revision;
+    entry->onDisk = onDisk;
+
+    // Drop the least recently used weeks beyond the budget
+    while (cache.entries.size() > SCHEDULE_CACHE_CAPACITY) {
+        cache.byKey.erase(cache.entries.back().key);
+        cache.entries.pop_back();
+    }
+    return *entry;
+}
+
+// Function to copy the slot state of a mapped schedule file into an expert
+// The masks on disk are the in-memory masks, so they are copied straight from the mapping
+void readScheduleLayout(const ScheduleFileLayout* layout, Expert& expert) {
+    for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+        expert.hoursWorkedPerDay[day] = layout->hoursWorked[day];
+    }
+    memcpy(expert.bookedMask, layout->bookedMask, DAYS_IN_WEEK);
+    memcpy(expert.treatmentMask, layout->treatmentMask, DAYS_IN_WEEK);
+    memcpy(expert.unavailableMask, layout->unavailableMask, DAYS_IN_WEEK);
+}
+
+// Function to write an expert's slot state into a mapped schedule file and bump its revision
+void writeScheduleLayout(const Expert& expert, ScheduleFileLayout* layout) {
+    memcpy(layout->magic, SCHEDULE_FILE_MAGIC, 4);
+    if (layout->version < 2) {
+        // New and version 1 files start from a random revision, so a week whose file was removed and
+        // created again does not repeat a revision the schedule cache may still hold
+        static mt19937 random(random_device{}());
+        layout->revision = static_cast<unsigned int>(random());
+    }
+    layout->version = SCHEDULE_FILE_VERSION;
+    layout->days = DAYS_IN_WEEK;
+    layout->slotsPerDay = MAX_SLOTS_PER_DAY;
+    layout->reserved = 0;
+    // Write each day's hours, then the slot masks exactly as the expert holds them
+    for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+        layout->hoursWorked[day] = static_cast<unsigned char>(expert.hoursWorkedPerDay[day]);
+    }
+    memcpy(layout->bookedMask, expert.bookedMask, DAYS_IN_WEEK);
+    memcpy(layout->treatmentMask, expert.treatmentMask, DAYS_IN_WEEK);
+    memcpy(layout->unavailableMask, expert.unavailableMask, DAYS_IN_WEEK);
+    layout->revision++;
+}
+
+// Function to apply a change to an expert-week while holding the schedule file's exclusive lock
+// The change sees the week as currently on disk and returns true when the slot state should be written back
+bool updateScheduleFile(Expert& expert, int week, const function<bool(Expert&, ScheduleFileLayout*)>& change) {
+    // Make sure a legacy text schedule has been migrated before the binary file is created
+    Expert current = expert;
+    if (!readScheduleFile(current, week)) {
+        initializeCleanSchedule(current);
+    }
+
+    createDirectoryIfNotExists("schedules");
+    string filename = scheduleFileName(expert.name, week);
+    MappedFile mapped;
+    if (!mapScheduleFile(filename, true, mapped)) {
+        cerr << RED << "Error opening file for writing: " << filename << RESET << endl;
+        return false;
+    }
+    ScheduleFileLayout* layout = reinterpret_cast<ScheduleFileLayout*>(mapped.data);
+    if (memcmp(layout->magic, SCHEDULE_FILE_MAGIC, 4) == 0) {
+        readScheduleLayout(layout, current); // Another terminal may have changed the week since it was read
+    }
+    else {
+        initializeCleanSchedule(current); // A new or unreadable file holds an empty week
+    }
+    if (memcmp(layout->magic, SCHEDULE_FILE_MAGIC, 4) != 0 || layout->version != SCHEDULE_FILE_VERSION) {
+        // New or older file: write the current header first so the change sees its final revision
+        // Holds of an older layout are dropped, as their tokens are laid out differently
+        memset(&layout->holds, 0, sizeof(layout->holds));
+        writeScheduleLayout(current, layout);
+    }
+    purgeExpiredHolds(layout, static_cast<long long>(time(nullptr)));
+
+    bool changed = change(current, layout);
+    if (changed) {
+        writeScheduleLayout(current, layout);
+    }
+    ScheduleBlock block;
+    packScheduleBlock(current, block);
+    mapped.discard = isEmptyScheduleBlock(block) && !hasActiveHolds(layout); // A week left empty gets no file
+    unsigned int revision = layout->revision;
+    unmapScheduleFile(mapped);
+
+    int expertId = findExpertId(expert.name);
+    if (expertId != -1) {
+        cacheSchedule(expertWeekKey(expertId, week), current, revision, !mapped.discard);
+    }
+    expert = current;
+    if (changed) {
+        updateAvailabilityIndex(expert, week); // Keep the next-available search current
+    }
+    return changed;
+}
+
+// Function to check whether any terminal still holds slots in a schedule file
+bool hasActiveHolds(const ScheduleFileLayout* layout) {
+    long long now = static_cast<long long>(time(nullptr));
+    for (int i = 0; i < SCHEDULE_HOLD_ENTRIES; ++i) {
+        if (layout->holds[i].token != 0 && layout->holds[i].expiresAt > now) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Function to free the hold entries whose time has run out
+void purgeExpiredHolds(ScheduleFileLayout* layout, long long now) {
+    for (int i = 0; i < SCHEDULE_HOLD_ENTRIES; ++i) {
+        if (layout->holds[i].token != 0 && layout->holds[i].expiresAt <= now) {
+            layout->holds[i].token = 0;
+        }
+    }
+}
+
+// Function to get the slots on a day held by any terminal other than the given hold token
+unsigned char heldSlots(const ScheduleFileLayout* layout, int day, unsigned long long ownToken) {
+    unsigned char mask = 0;
+    for (int i = 0; i < SCHEDULE_HOLD_ENTRIES; ++i) {
+        if (layout->holds[i].token != 0 && layout->holds[i].token != ownToken && layout->holds[i].day == day) {
+            mask |= layout->holds[i].mask;
+        }
+    }
+    return mask;
+}
+
+// Function to generate a hold token that is unique across terminals
+// The full process ID fills the high half; the low half counts from a random start, so a reused process ID
+// does not repeat the tokens of a terminal whose holds have not lapsed yet
+unsigned long long newHoldToken() {
+    static unsigned int sequence = random_device{}();
+#ifdef _WIN32
+    unsigned long long process = static_cast<unsigned long long>(GetCurrentProcessId());
+#else
+    unsigned long long process = static_cast<unsigned long long>(getpid());
+#endif
+    unsigned long long token = (process << 32) | ++sequence;
+    return token == 0 ? 1 : token;
+}
+
+// Function to hold slots for a booking while the customer confirms and pays
+// Fails if the slots were booked or are held by another terminal since the schedule was displayed
+bool placeSlotHold(Expert& expert, int week, int day, int slot, SessionType sessionType, int duration, SlotHold& hold) {
+    if (!isBookableDate(week, day)) {
+        return false; // Past dates and weeks beyond the booking horizon cannot be held
+    }
+    unsigned char run = slotRunMask(slot, duration);
+    bool placed = false;
+
+    SlotHold candidate;
+    candidate.token = newHoldToken();
+    candidate.expertId = registerExpert(expert.name);
+    candidate.week = week;
+    candidate.day = day;
+    candidate.slot = slot;
+    candidate.sessionType = sessionType;
+    candidate.duration = duration;
+
+    updateScheduleFile(expert, week, [&](Expert& current, ScheduleFileLayout* layout) {
+        if (!canBookSlot(current, day, slot, duration) || (heldSlots(layout, day, 0) & run) != 0) {
+            return false; // Taken or held elsewhere
+        }
+        for (int i = 0; i < SCHEDULE_HOLD_ENTRIES; ++i) {
+            if (layout->holds[i].token == 0) {
+                layout->holds[i].token = candidate.token;
+                layout->holds[i].day = static_cast<unsigned char>(day);
+                layout->holds[i].mask = run;
+                layout->holds[i].expiresAt = static_cast<long long>(time(nullptr)) + SLOT_HOLD_SECONDS;
+                placed = true;
+                break;
+            }
+        }
+        candidate.revision = layout->revision;
+        return false; // Holds do not change the slot state
+    });
+    if (placed) {
+        hold = candidate;
+    }
+    return placed;
+}
+
+// Function to turn a hold into a booking, re-checking the slots only if the week changed since the hold was placed
+// The expert is refreshed to the committed state; returns false if the slots were lost to another terminal
+bool commitSlotHold(Expert& expert, const SlotHold& hold) {
+    int duration = hold.duration;
+    unsigned char run = slotRunMask(hold.slot, duration);
+
+    bool committed = updateScheduleFile(expert, hold.week, [&](Expert& current, ScheduleFileLayout* layout) {
+        bool stillHeld = false;
+        for (int i = 0; i < SCHEDULE_HOLD_ENTRIES; ++i) {
+            if (layout->holds[i].token == hold.token) {
+                layout->holds[i].token = 0; // The hold ends here either way
+                stillHeld = true;
+            }
+        }
+        // A lapsed hold, or a week another terminal has written to, must be validated again
+        if (!stillHeld || layout->revision != hold.revision) {
+            if (!canBookSlot(current, hold.day, hold.slot, duration) ||
+                (heldSlots(layout, hold.day, hold.token) & run) != 0) {
+                return false;
+            }
+        }
+
+        bookSlots(current, hold.day, hold.slot, duration, hold.sessionType); // Mark the slots as booked and update hours worked
+        if (current.hoursWorkedPerDay[hold.day] >= MAX_WORK_HOURS) {
+            // If the expert reaches the max hours, mark remaining slots as unavailable
+            unsigned char openSlots = ~current.bookedMask[hold.day] & ALL_SLOTS_MASK;
+            current.unavailableMask[hold.day] |= openSlots;
+            current.treatmentMask[hold.day] &= ~openSlots;
+        }
+        return true;
+    });
+    return committed; // The schedule file is durable once the update returns; the booking itself is logged by saveBooking
+}
+
+// Function to give up a hold without booking, e.g. when the customer cancels
+void releaseSlotHold(const SlotHold& hold) {
+    if (hold.token == 0) {
+        return;
+    }
+    Expert expert = getExpert(hold.expertId);
+    updateScheduleFile(expert, hold.week, [&](Expert&, ScheduleFileLayout* layout) {
+        for (int i = 0; i < SCHEDULE_HOLD_ENTRIES; ++i) {
+            if (layout->holds[i].token == hold.token) {
+                layout->holds[i].token = 0;
+            }
+        }
+        return false;
+    });
+}
+
+// Function to load an expert's schedule from a legacy text schedule file
+bool loadScheduleFromTextFile(Expert& expert, int weekNumber) {
+    // Construct the filename for the schedule based on the expert's name and week number
+    string filename = legacyScheduleFileName(expert.name, weekNumber, "_schedule.txt");
+    if (filename.empty()) {
+        return false; // Only weeks of July 2024 had text schedules
+    }
+    ifstream scheduleFile(filename); // Open the schedule file for reading
+
+    if (scheduleFile.is_open()) {
+        string line;
+        int week = -1; // Variable to track the current week (not used)
+        int day = -1; // Variable to track the current day
+
+        // Read the file line by line
+        while (getline(scheduleFile, line)) {
+            // Check for lines indicating a new day
+            if (line.find("Day") == 0) {
+                day = stoi(line.substr(4)) - 1; // Extract day number
+                continue; // Move to the next line
+            }
+            if (day >= 0) {
+                stringstream ss(line); // Create a string stream to parse the line
+                int hoursWorked;
+                // Attempt to read hours worked, handle errors if parsing fails
+                if (!(ss >> hoursWorked)) {
+                    cerr << RED << "Error parsing hoursWorked: " << line << RESET << endl;
+                    continue; // Skip to the next line
+                }
+                expert.hoursWorkedPerDay[day] = hoursWorked; // Store hours worked for the day
+
+                // Read the schedule for each time slot of the day
+                for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
+                    char isBooked, typeChar;
+                    // Attempt to read booking status and type, handle errors if parsing fails
+                    if (!(ss >> isBooked >> typeChar)) {
+                        cerr << RED << "Error reading slot data for Week " << week + 1 << " Day " << day + 1 << " from line: " << line << RESET << endl;
+                        break; // Break out of the loop if there's an error
+                    }
+                    unsigned char bit = 1 << slot;
+                    // Set booking status based on the read data
+                    if (isBooked == '1') expert.bookedMask[day] |= bit;
+                    else expert.bookedMask[day] &= ~bit;
+                    // Determine the type of session based on the character read
+                    expert.treatmentMask[day] &= ~bit;
+                    expert.unavailableMask[day] &= ~bit;
+                    if (typeChar == 'T') expert.treatmentMask[day] |= bit;
+                    else if (typeChar != 'C') expert.unavailableMask[day] |= bit;
+                }
+            }
+        }
+        scheduleFile.close(); // Close the schedule file after reading
+        return true;
+    }
+    return false; // No legacy file for this expert and week
+}
 
 // Function to handle payment methods and process the payment
 bool handlePaymentMethod(PaymentMethod method) {
@@ -1020,74 +2817,146 @@ PaymentMethod selectPaymentMethod() {
     }
 }
 
-// Function to load the booking counter from a file
-int loadBookingCounter(const string& filename) {
-    int counter = 0; // Initialize counter to 0
-    ifstream bookingCounterFile(filename); // Open the booking counter file
-
-    // Check if the file is successfully opened
-    if (bookingCounterFile.is_open()) {
-        bookingCounterFile >> counter; // Read the counter value
-        bookingCounterFile.close(); // Close the file
+// Function to durably reserve a block of booking IDs under an exclusive lock on the counter file
+// The file holds the highest ID reserved so far, so older files holding the last issued number still work
+bool reserveBookingIds(const string& filename, long long count, long long& firstId) {
+    FILE* counterFile = fopen(filename.c_str(), "a+");
+    if (counterFile == nullptr) {
+        cerr << RED << "Error: Unable to open file " << filename << RESET << endl;
+        return false;
+    }
+#ifdef _WIN32
+    _locking(_fileno(counterFile), _LK_LOCK, 1); // Blocks until no other terminal holds the counter
+#else
+    flock(fileno(counterFile), LOCK_EX);         // Blocks until no other terminal holds the counter
+#endif
+    long long reserved = 0;
+    rewind(counterFile);
+    if (fscanf(counterFile, "%lld", &reserved) != 1) {
+        reserved = 0; // New counter file
+    }
+    firstId = reserved + 1;
+
+    // Record the end of the new block before any ID from it is handed out
+    bool saved = false;
+    FILE* updated = fopen(filename.c_str(), "w");
+    if (updated != nullptr) {
+        saved = fprintf(updated, "%lld", reserved + count) > 0;
+        fflush(updated);
+#ifndef _WIN32
+        fsync(fileno(updated));
+#endif
+        fclose(updated);
+    }
+#ifdef _WIN32
+    rewind(counterFile);
+    _locking(_fileno(counterFile), _LK_UNLCK, 1);
+#else
+    flock(fileno(counterFile), LOCK_UN);
+#endif
+    fclose(counterFile);
+    if (!saved) {
+        cerr << RED << "Error: Unable to reserve booking numbers in " << filename << RESET << endl;
     }
-    return counter; // Return the booking counter
+    return saved;
 }
 
-// Function to save the booking counter to a file
-void saveBookingCounter(const string& filename, int counter) {
-    ofstream bookingCounterFile(filename); // Open the booking counter file for writing
-    if (bookingCounterFile.is_open()) {
-        bookingCounterFile << counter; // Write the counter value
-        bookingCounterFile.close(); // Close the file
-    }
-    else {
-        cerr << RED << "Error: Unable to open file " << filename << RESET << endl; // Handle file opening error
+// Function to get the process-wide booking ID allocator
+BookingIdAllocator& getBookingIdAllocator() {
+    static BookingIdAllocator allocator;
+    return allocator;
+}
+
+// Function to hand out a unique booking ID, reserving a new block from the counter file when the current one runs out
+// Returns -1 if no block could be reserved
+long long allocateBookingId() {
+    BookingIdAllocator& allocator = getBookingIdAllocator();
+    for (;;) {
+        unsigned long long id = allocator.next.fetch_add(1); // Every candidate is seen by exactly one caller
+        unsigned long long block = allocator.block.load();
+        if (id >= (block >> 32) && id < (block & 0xFFFFFFFFULL)) {
+            return static_cast<long long>(id);
+        }
+
+        lock_guard<mutex> lock(allocator.refill);
+        block = allocator.block.load();
+        if (allocator.next.load() < (block & 0xFFFFFFFFULL)) {
+            continue; // Another caller already reserved a fresh block
+        }
+        long long firstId;
+        if (!reserveBookingIds(BOOKING_COUNTER_FILE, BOOKING_ID_BLOCK_SIZE, firstId)) {
+            return -1;
+        }
+        unsigned long long start = static_cast<unsigned long long>(firstId);
+        allocator.block.store((start << 32) | (start + BOOKING_ID_BLOCK_SIZE));
+
+        // Move the candidate counter up to the new block; it never moves back, so no ID repeats
+        unsigned long long current = allocator.next.load();
+        while (current < start && !allocator.next.compare_exchange_weak(current, start)) {
+        }
     }
 }
 
-// Function to generate a new booking number
+// Function to generate the next booking number, e.g. B00000042, which sorts in issue order
 string generateBookingNumber() {
-    static int bookingCounter = loadBookingCounter("booking_counter.txt"); // Load the current booking counter
+    long long id = allocateBookingId();
+    if (id < 0) {
+        return ""; // Counter file unavailable
+    }
     stringstream ss; // Create a string stream for formatting the booking number
-    ss << "B" << setw(3) << setfill('0') << ++bookingCounter; // Format the booking number
-    saveBookingCounter("booking_counter.txt", bookingCounter); // Save the updated booking counter
+    ss << "B" << setw(BOOKING_NUMBER_DIGITS) << setfill('0') << id; // Format the booking number
     return ss.str(); // Return the formatted booking number
 }
 
+// Function to compose the full text of a receipt, shared by the screen and the receipt file
+void appendReceipt(string& out, const Receipt& receipt) {
+    // Receipt header and company information
+    static const string header =
+        "   __             _                                       __                              \n"
+        "  / /  ___   ___ | | _____ _ __ ___   __ ___  ____  __   / /  ___  _   _ _ __   __ _  ___ \n"
+        " / /  / _ \\ / _ \\| |/ / __| '_ ` _ \\ / _` \\ \\/ /\\ \\/ /  / /  / _ \\| | | | '_ \\ / _` |/ _ \\\n"
+        "/ /__| (_) | (_) |   <\\__ \\ | | | | | (_| |>  <  >  <  / /__| (_) | |_| | | | | (_| |  __/\n"
+        "\\____/\\___/ \\___/|_|\\_\\___/_| |_| |_|\\__,_/_/\\_\\/_/\\_\\ \\____/\\___/ \\__,_|_| |_|\\__, |\\___|\n"
+        "                                                                               |___/      \n"
+        "                                  LOOKSMAXXLOUNGE @LOOKSMAXXAREA\n"
+        "                                         Lot 23, 2nd Floor,\n"
+        "                                     Plaza Crystal, Jalan Ampang,\n"
+        "                                         50450 Kuala Lumpur,\n"
+        "                                 Wilayah Persekutuan Kuala Lumpur,\n"
+        "                                             Malaysia\n"
+        "                           *********************************************\n"
+        "                           *               SERVICE RECEIPT             *\n"
+        "                           *********************************************\n\n";
+    static const string footer =
+        "                           ---------------------------------------------\n\n"
+        "                           Thank you for choosing our services!\n"
+        "                           For inquiries, call us at +60-123-4567 or\n"
+        "                           email us at looksmaxxlounge@serviceprovider.com\n"
+        "                           ---------------------------------------------\n";
+    const string margin(27, ' ');
+
+    out += header;
+    // Receipt details
+    out += margin + "Booking Number:" + receipt.bookingNumber + "\n";
+    out += margin + "Customer Name:" + receipt.customer.name + "\n";
+    out += margin + "Expert:" + getExpertName(receipt.expertId) + "\n";
+    out += margin + "Session:" + (receipt.sessionType == TREATMENT ? "Treatment" : "Consultation") + "\n";
+    out += margin + "Service:" + getService(receipt.serviceId).name + "\n";
+    out += margin + "Date:" + bookingDateText(receipt) + "\n";
+    out += margin + "Time Slot:" + receipt.timeSlot + "\n";
+    out += margin + "Payment Method:" + paymentMethodToString(receipt.paymentMethod) + "\n";
+    out += margin + "+-------------------------------------------+\n\n";
+    out += margin + "Amount Paid:RM ";
+    appendMoney(out, receipt.amountPaid, 0);
+    out += "\n";
+    out += footer;
+}
+
 // Function to generate a receipt and print it to the console
 void generateReceipt(const Receipt& receipt) {
-    // Print receipt header and company information
-    cout << "   __             _                                       __                              " << endl;
-    cout << "  / /  ___   ___ | | _____ _ __ ___   __ ___  ____  __   / /  ___  _   _ _ __   __ _  ___ " << endl;
-    cout << " / /  / _ \\ / _ \\| |/ / __| '_ ` _ \\ / _` \\ \\/ /\\ \\/ /  / /  / _ \\| | | | '_ \\ / _` |/ _ \\" << endl;
-    cout << "/ /__| (_) | (_) |   <\\__ \\ | | | | | (_| |>  <  >  <  / /__| (_) | |_| | | | | (_| |  __/" << endl;
-    cout << "\\____/\\___/ \\___/|_|\\_\\___/_| |_| |_|\\__,_/_/\\_\\/_/\\_\\ \\____/\\___/ \\__,_|_| |_|\\__, |\\___|" << endl;
-    cout << "                                                                               |___/      " << endl;
-    cout << "                                  LOOKSMAXXLOUNGE @LOOKSMAXXAREA" << endl;
-    cout << "                                         Lot 23, 2nd Floor,\n";
-    cout << "                                     Plaza Crystal, Jalan Ampang,\n";
-    cout << "                                         50450 Kuala Lumpur,\n";
-    cout << "                                 Wilayah Persekutuan Kuala Lumpur,\n";
-    cout << "                                             Malaysia\n";     
-    cout << "                           *********************************************\n";
-    cout << "                           *               SERVICE RECEIPT             *\n";
-    cout << "                           *********************************************\n\n";
-    // Print receipt details
-    cout << "                           Booking Number:" << receipt.bookingNumber << endl;
-    cout << "                           Customer Name:" << receipt.customer.name << endl;
-    cout << "                           Expert:" << receipt.expert.name << endl;
-    cout << "                           Session:" << (receipt.sessionType == TREATMENT ? "Treatment" : "Consultation") << endl;
-    cout << "                           Service:" << receipt.serviceName << endl;
-    cout << "                           Date:" << trim(receipt.date) + " July 2024" << endl;
-    cout << "                           Time Slot:" << receipt.timeSlot << endl;
-    cout << "                           Payment Method:" << paymentMethodToString(receipt.paymentMethod) << endl;
-    cout << "                           +-------------------------------------------+\n\n";
-    cout << "                           Amount Paid:" << "RM " << fixed << setprecision(2) << receipt.amountPaid << endl;
-    cout << "                           ---------------------------------------------\n\n";
-    cout << "                           Thank you for choosing our services!\n";
-    cout << "                           For inquiries, call us at +60-123-4567 or\n";
-    cout << "                           email us at looksmaxxlounget@serviceprovider.com\n";
-    cout << "                           ---------------------------------------------\n";
+    string& screen = getScreenBuffer();
+    appendReceipt(screen, receipt);
+    flushScreen(screen);
 }
 
 // Function to generate a receipt file and save it to the specified filename
@@ -1101,53 +2970,67 @@ void generateReceiptFile(const Receipt& receipt, const string& filename) {
         cerr << RED << "Error: Unable to open file " << filename << RESET << endl;
         return; // Exit if unable to open file
     }
-    // Print receipt header and company information to the file
-    receiptFile << "   __             _                                       __                              " << endl;
-    receiptFile << "  / /  ___   ___ | | _____ _ __ ___   __ ___  ____  __   / /  ___  _   _ _ __   __ _  ___ " << endl;
-    receiptFile << " / /  / _ \\ / _ \\| |/ / __| '_ ` _ \\ / _` \\ \\/ /\\ \\/ /  / /  / _ \\| | | | '_ \\ / _` |/ _ \\" << endl;
-    receiptFile << "/ /__| (_) | (_) |   <\\__ \\ | | | | | (_| |>  <  >  <  / /__| (_) | |_| | | | | (_| |  __/" << endl;
-    receiptFile << "\\____/\\___/ \\___/|_|\\_\\___/_| |_| |_|\\__,_/_/\\_\\/_/\\_\\ \\____/\\___/ \\__,_|_| |_|\\__, |\\___|" << endl;
-    receiptFile << "                                                                               |___/      " << endl;
-    receiptFile << "                                  LOOKSMAXXLOUNGE @LOOKSMAXXAREA" << endl;
-    receiptFile << "                                         Lot 23, 2nd Floor,\n";
-    receiptFile << "                                     Plaza Crystal, Jalan Ampang,\n";
-    receiptFile << "                                         50450 Kuala Lumpur,\n";
-    receiptFile << "                                 Wilayah Persekutuan Kuala Lumpur,\n";
-    receiptFile << "                                             Malaysia\n";
-    receiptFile << "                           *********************************************\n";
-    receiptFile << "                           *               SERVICE RECEIPT             *\n";
-    receiptFile << "                           *********************************************\n\n";
-    // Print receipt details to the file
-    receiptFile << "                           Booking Number:" << receipt.bookingNumber << endl;
-    receiptFile << "                           Customer Name:" << receipt.customer.name << endl;
-    receiptFile << "                           Expert:" << receipt.expert.name << endl;
-    receiptFile << "                           Session:" << (receipt.sessionType == TREATMENT ? "Treatment" : "Consultation") << endl;
-    receiptFile << "                           Service:" << receipt.serviceName << endl;
-    receiptFile << "                           Date:" << trim(receipt.date) + " July 2024" << endl;
-    receiptFile << "                           Time Slot:" << receipt.timeSlot << endl;
-    receiptFile << "                           Payment Method:" << paymentMethodToString(receipt.paymentMethod) << endl;
-    receiptFile << "                           +-------------------------------------------+\n\n";
-    receiptFile << "                           Amount Paid:" << "RM " << fixed << setprecision(2) << receipt.amountPaid << endl;
-    receiptFile << "                           ---------------------------------------------\n\n";
-    receiptFile << "                           Thank you for choosing our services!\n";
-    receiptFile << "                           For inquiries, call us at +60-123-4567 or\n";
-    receiptFile << "                           email us at looksmaxxlounge@serviceprovider.com\n";
-    receiptFile << "                           ---------------------------------------------\n";
+    // Compose the receipt once and write it in a single call
+    string text;
+    appendReceipt(text, receipt);
+    receiptFile.write(text.data(), text.size());
 
     // Close the receipt file after writing
     receiptFile.close();
 }
 
-// Function to print the receipt file using the default application
-void printReceipt(const string& filename) {
-#ifdef _WIN32
-    // On Windows, use ShellExecute to open the receipt file
-    ShellExecute(NULL, L"open", wstring(filename.begin(), filename.end()).c_str(), NULL, NULL, SW_SHOWNORMAL);
-#else   
-    // On other platforms, use the open command to print the file
-    string command = "open " + filename;
-    system(command.c_str());
-#endif
+// Function to get where printed receipts are sent
+ReceiptSink& getReceiptSink() {
+    static ReceiptSink sink;
+    return sink;
+}
+
+// Function to parse a receipt sink option: "file", "stdout", "spool" or "spool:DIR"
+bool parseReceiptSink(const string& value, ReceiptSink& sink) {
+    if (value == "file") {
+        sink.type = RECEIPT_TO_FILE;
+    }
+    else if (value == "stdout") {
+        sink.type = RECEIPT_TO_STDOUT;
+    }
+    else if (value == "spool" || value.compare(0, 6, "spool:") == 0) {
+        sink.type = RECEIPT_TO_SPOOL;
+        if (value.length() > 6) {
+            sink.spoolDirectory = value.substr(6);
+        }
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+// Function to deliver a receipt to the configured sink without starting another program
+void printReceipt(const Receipt& receipt, const string& filename) {
+    const ReceiptSink& sink = getReceiptSink();
+    if (sink.type == RECEIPT_TO_STDOUT) {
+        generateReceipt(receipt); // Print straight to the console
+        return;
+    }
+    if (sink.type == RECEIPT_TO_SPOOL) {
+        // Write under a temporary name and rename, so a print spooler never picks up half a receipt
+        createDirectoryIfNotExists(sink.spoolDirectory);
+        string spoolPath = sink.spoolDirectory + "/receipt_" + receipt.bookingNumber + ".txt";
+        string partialPath = sink.spoolDirectory + "/.receipt_" + receipt.bookingNumber + ".part";
+        string text;
+        appendReceipt(text, receipt);
+        ofstream spoolFile(partialPath, ios::binary);
+        spoolFile.write(text.data(), text.size());
+        spoolFile.close();
+        if (!spoolFile || rename(partialPath.c_str(), spoolPath.c_str()) != 0) {
+            remove(partialPath.c_str());
+            cerr << RED << "Error: Unable to spool receipt to " << sink.spoolDirectory << RESET << endl;
+            return;
+        }
+        cout << "Receipt sent to the print spool: " << spoolPath << endl;
+        return;
+    }
+    cout << "Receipt saved to " << filename << endl;
 }
 
 // Function to make a booking for a service with an expert
@@ -1160,113 +3043,176 @@ void makeBooking(Expert& expert, Service service, SessionType sessionType, Custo
     }
     loadScheduleFromFile(expert, chosenWeek); // Load the expert's schedule for the chosen week
     displaySchedule(expert, chosenWeek);  // Display the loaded schedule
-    // Set the price based on session type
-    double price = sessionType == TREATMENT ? service.price : 60.0;
 
     // Prompt user to select a time slot
-    int* result = selectTimeSlot(expert, chosenWeek, sessionType);
+    int* result = selectTimeSlot(expert, chosenWeek, serviceDuration(service, sessionType));
     if (result == nullptr) {
         return; // Exit if no valid time slot is selected
     }
     int day = result[0];
     int slot = result[1];
 
-    // Calculate the date for the booking
-    int startDate = 1 + (chosenWeek * 7);
-    int date = startDate + day;
-
     // Check if a valid day and slot are selected
     if (day != -1 && slot != -1) {
-        // Book the selected time slot
-        int duration = (sessionType == TREATMENT) ? TREATMENT_SLOT_DURATION : CONSULTATION_SLOT_DURATION;
-        for (int i = 0; i < duration; ++i) {
-            expert.schedule[day][slot + i].isBooked = true; // Mark the slot as booked
-            expert.schedule[day][slot + i].type = sessionType; // Set the session type
-        }
-        expert.hoursWorkedPerDay[day] += duration; // Update hours worked for the expert
-
-        // Generate time range for the booking
-        string startTime = to_string(START_HOUR + slot) + ":00";
-        string endTime = to_string(START_HOUR + slot + duration) + ":00";
-        clearScreen();  // Clear the screen for confirmation
-        // Display booking confirmation details
-        cout << "==========================================" << endl;
-        cout << "          Booking Confirmation           " << endl;
-        cout << "==========================================" << endl;
-        cout << "Please confirm your booking details: \n";
-        cout << "Service: " << service.name << endl; // Display selected service
-        cout << "Session Type: " << (sessionType == TREATMENT ? "Treatment" : "Consultation") << endl; // Show session type
-        cout << "Date: " << to_string(date) << " July 2024" << endl; // Display booking date
-        cout << "Time Slot: " << startTime << " - " << endTime << endl; // Show time slot
-        cout << "Price: RM " << fixed << setprecision(2) << price << endl; // Show total price
-        cout << "==========================================" << endl;
-        // Prompt the user to confirm the booking
-        cout << "Confirm booking? (Y to proceed to payment/ any other key to stop booking): ";
-        char confirm; // Variable to hold user confirmation input
-        cin >> confirm; // Read user input
-
-        // Check if the user confirmed the booking
-        if (tolower(confirm) == 'y') {
-            // User confirmed, proceed to payment selection
-            PaymentMethod paymentMethod = selectPaymentMethod();  // Select payment method
-            if (paymentMethod == CANCELLED) { // Check if payment selection was canceled
-                return; // Exit the function if canceled
-            }
-            // Verify payment method
-            if (handlePaymentMethod(paymentMethod)) {
-                // Verify payment method
-                string bookingNumber = generateBookingNumber();
-                // Create a receipt with booking details
-                Receipt receipt = { bookingNumber, customer, expert, sessionType, service.name, to_string(date), startTime + " - " + endTime, paymentMethod, price };
-                generateReceipt(receipt); // Generate the receipt for printing
-
-                // Display success message for the booking
-                cout << "==========================================" << endl;
-                cout << "             Booking Succeed              " << endl;
-                cout << "==========================================" << endl;
-                cout << "You have successfully booked the slot on Day " << day + 1
-                    << " from " << expert.schedule[day][slot].timeRange.substr(0, 5) << " to " << endTime
-                    << " with " << expert.name << " for " << service.name << " ("
-                    << (sessionType == TREATMENT ? "Treatment" : "Consultation") << ")." << endl;
-                cout << "==========================================" << endl;
-
-                if (expert.hoursWorkedPerDay[day] >= MAX_WORK_HOURS) {
-                    // If the expert reaches the max hours, mark remaining slots as unavailable
-                    for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
-                        if (!expert.schedule[day][slot].isBooked) {
-                            expert.schedule[day][slot].type = UNAVAILABLE;
-                        }
-                    }
-                    cout << "Expert has reached the maximum working hours for the day. Remaining slots are now unavailable.\n";
-                }
+        confirmBooking(expert, chosenWeek, day, slot, service, sessionType, customer);
+    }
+}
 
-                // Prepare to save the receipt to a file
-                string receiptFileName = "receipts/receipt_" + bookingNumber + ".txt";
-                generateReceiptFile(receipt, receiptFileName); // Save the receipt to a file
-                printReceipt(receiptFileName); // Print the receipt
-
-                // Save the booking information and updated schedule
-                saveBooking(receipt); // Save booking details
-                saveScheduleToFile(expert, chosenWeek); // Save updated schedule to file
-            } else {
-                // Payment verification failed, inform the user
-                cout << RED << "Payment verification failed. Booking canceled." << RESET << endl;
-            }
+// Function to confirm, pay for and save a booking of a chosen slot
+void confirmBooking(Expert& expert, int chosenWeek, int day, int slot, Service service, SessionType sessionType, Customer& customer) {
+    // Set the price based on session type
+    double price = servicePrice(service, sessionType);
+
+    // Calculate the date for the booking
+    int date = weekStartDay(chosenWeek) + day;
+
+    // Hold the selected time slot so no other terminal can take it while the customer confirms and pays
+    int duration = serviceDuration(service, sessionType);
+    SlotHold hold;
+    if (!placeSlotHold(expert, chosenWeek, day, slot, sessionType, duration, hold)) {
+        cout << RED << "Sorry, that slot has just been taken or is being booked at another terminal." << RESET << endl;
+        return;
+    }
+
+    // Generate time range for the booking
+    string startTime = to_string(START_HOUR + slot) + ":00";
+    string endTime = to_string(START_HOUR + slot + duration) + ":00";
+    clearScreen();  // Clear the screen for confirmation
+    // Display booking confirmation details
+    cout << "==========================================" << endl;
+    cout << "          Booking Confirmation           " << endl;
+    cout << "==========================================" << endl;
+    cout << "Please confirm your booking details: \n";
+    cout << "Service: " << service.name << endl; // Display selected service
+    cout << "Session Type: " << (sessionType == TREATMENT ? "Treatment" : "Consultation") << endl; // Show session type
+    cout << "Date: " << formatDate(date) << endl; // Display booking date
+    cout << "Time Slot: " << startTime << " - " << endTime << endl; // Show time slot
+    cout << "Price: RM " << fixed << setprecision(2) << price << endl; // Show total price
+    cout << "==========================================" << endl;
+    // Prompt the user to confirm the booking
+    cout << "Confirm booking? (Y to proceed to payment/ any other key to stop booking): ";
+    char confirm; // Variable to hold user confirmation input
+    cin >> confirm; // Read user input
+
+    // Check if the user confirmed the booking
+    if (tolower(confirm) == 'y') {
+        // User confirmed, proceed to payment selection
+        PaymentMethod paymentMethod = selectPaymentMethod();  // Select payment method
+        if (paymentMethod == CANCELLED) { // Check if payment selection was canceled
+            releaseSlotHold(hold);
+            return; // Exit the function if canceled
         }
-        else {
-            // User chose not to confirm the booking
-            cout << "Booking cancelled." << endl;
+        // Verify payment method
+        if (handlePaymentMethod(paymentMethod)) {
+            // Issue the booking number while the slots are still only held
+            string bookingNumber = generateBookingNumber();
+            if (bookingNumber.empty()) {
+                releaseSlotHold(hold);
+                cout << RED << "Unable to issue a booking number. Booking canceled." << RESET << endl;
+                return;
+            }
+            // Book the held slots, unless another terminal got them after the hold lapsed
+            if (!commitSlotHold(expert, hold)) {
+                cout << RED << "Sorry, the slot was booked elsewhere while payment was pending. Booking canceled." << RESET << endl;
+                return;
+            }
+            // Create a receipt with booking details and save it before anything is issued to the customer
+            Receipt receipt = buildReceipt(bookingNumber, customer, expert, chosenWeek, day, slot, service, sessionType, paymentMethod, price);
+            if (!saveBooking(receipt)) {
+                updateExpertSchedules({ receipt }); // Free the committed slots again
+                cout << RED << "Unable to save the booking. Booking canceled." << RESET << endl;
+                return;
+            }
+            generateReceipt(receipt); // Generate the receipt for printing
+
+            // Display success message for the booking
+            cout << "==========================================" << endl;
+            cout << "             Booking Succeed              " << endl;
+            cout << "==========================================" << endl;
+            cout << "You have successfully booked the slot on " << formatDate(date)
+                << " from " << startTime << " to " << endTime
+                << " with " << expert.name << " for " << service.name << " ("
+                << (sessionType == TREATMENT ? "Treatment" : "Consultation") << ")." << endl;
+            cout << "==========================================" << endl;
+
+            if (expert.hoursWorkedPerDay[day] >= MAX_WORK_HOURS) {
+                // Remaining slots were marked unavailable when the hold was committed
+                cout << "Expert has reached the maximum working hours for the day. Remaining slots are now unavailable.\n";
+            }
+
+            // Prepare to save the receipt to a file
+            string receiptFileName = "receipts/receipt_" + bookingNumber + ".txt";
+            generateReceiptFile(receipt, receiptFileName); // Save the receipt to a file
+            printReceipt(receipt, receiptFileName); // Print the receipt
+        } else {
+            // Payment verification failed, inform the user
+            releaseSlotHold(hold);
+            cout << RED << "Payment verification failed. Booking canceled." << RESET << endl;
         }
     }
+    else {
+        // User chose not to confirm the booking
+        releaseSlotHold(hold);
+        cout << "Booking cancelled." << endl;
+    }
+}
+
+// Function to build the receipt for a booked slot
+Receipt buildReceipt(const string& bookingNumber, const Customer& customer, const Expert& expert, int week, int day, int slot,
+    const Service& service, SessionType sessionType, PaymentMethod paymentMethod, double price) {
+    int duration = serviceDuration(service, sessionType);
+    string date = isoDate(weekStartDay(week) + day);
+    string timeSlot = to_string(START_HOUR + slot) + ":00 - " + to_string(START_HOUR + slot + duration) + ":00";
+    return { bookingNumber, customer, registerExpert(expert.name), week, day, slot, duration, sessionType, service.id, date, timeSlot, paymentMethod, price };
+}
+
+// Function to list the earliest open slots with any expert and book the one the customer picks
+void bookFirstAvailable(Service service, SessionType sessionType, Customer& customer) {
+    const string days[5] = { "Mon", "Tue", "Wed", "Thu", "Fri" };
+    int duration = serviceDuration(service, sessionType);
+    vector<SlotCandidate> candidates = findNextAvailableSlots(duration, NEXT_AVAILABLE_RESULTS);
+    if (candidates.empty()) {
+        cout << RED << "No open " << (sessionType == TREATMENT ? "treatment" : "consultation") << " slots in the next "
+            << CALENDAR_HORIZON_WEEKS << " weeks." << RESET << endl;
+        return;
+    }
+
+    // Display the earliest candidates in time order
+    cout << "\nEarliest available slots:\n";
+    cout << "+------+---------+-----------------------+-----------------+" << endl;
+    cout << "|  No  | Expert  | Date                  | Time            |" << endl;
+    cout << "+------+---------+-----------------------+-----------------+" << endl;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const SlotCandidate& candidate = candidates[i];
+        string date = days[candidate.day] + " " + formatDate(weekStartDay(candidate.week) + candidate.day);
+        string time = to_string(START_HOUR + candidate.slot) + ":00 - " + to_string(START_HOUR + candidate.slot + duration) + ":00";
+        cout << "| " << BLUE << "[" << setw(2) << right << i + 1 << "]" << RESET << " | " << setw(7) << left << getExpertName(candidate.expertId)
+            << " | " << setw(21) << left << date << " | " << setw(15) << left << time << " |" << endl;
+    }
+    cout << "+------+---------+-----------------------+-----------------+" << endl;
+    cout << "Select a slot to book (-999 to go back): ";
+    int choice = getValidatedInput(1, static_cast<int>(candidates.size()));
+    if (choice == -999) {
+        return;
+    }
+
+    // Re-read the chosen week so the booking is made against the saved schedule
+    const SlotCandidate& chosen = candidates[choice - 1];
+    Expert expert = getExpert(chosen.expertId);
+    loadScheduleFromFile(expert, chosen.week);
+    if (!canBookSlot(expert, chosen.day, chosen.slot, duration)) {
+        cout << RED << "That slot has just been taken. Please search again." << RESET << endl;
+        return;
+    }
+    confirmBooking(expert, chosen.week, chosen.day, chosen.slot, service, sessionType, customer);
 }
 
 // Function to manage customer-related operations
 void customerManagement() {
-    Customer customers[100]; // Array to hold customer data
-    int choice, customerCount = 0; // Variables for user choice and customer count
+    int choice; // Variable for user choice
     int loggedInCustomerIndex = -1; // Index of the logged-in customer
     clearScreen(); // Clear the screen for a fresh display
-    loadCustomersFromFile(customers, customerCount); // Load customer data from a file
+    CustomerDirectory& directory = getCustomerDirectory(); // Customer data is loaded once per run
 
     // Loop for customer management options
     do {
@@ -1285,13 +3231,13 @@ void customerManagement() {
 
         switch (choice) { // Handle user choice
         case 1:
-            customerSignUp(customers, customerCount); // Call sign-up function for new customers
+            customerSignUp(directory); // Call sign-up function for new customers
             pauseAndClear(); // Pause and clear the screen after signing up
             break;
         case 2:
-            loggedInCustomerIndex = customerLogin(customers, customerCount); // Call login function
+            loggedInCustomerIndex = customerLogin(directory); // Call login function
             if (loggedInCustomerIndex != -1) { // Check if login was successful
-                customerMenu(customers[loggedInCustomerIndex]); // Show customer menu for the logged-in customer
+                customerMenu(directory.customers[loggedInCustomerIndex]); // Show customer menu for the logged-in customer
             }
             pauseAndClear(); // Pause and clear the screen after login
             break;
@@ -1303,42 +3249,176 @@ void customerManagement() {
     } while (choice != 3); // Continue until the user chooses to go back
 }
 
-// Function to validate customer names using a regex pattern
-bool isValidName(const string& name) {
-    const regex pattern("^[A-Za-z]+(?: [A-Za-z]+)*$");
-    return regex_match(trim(name), pattern);
+// Function to get the character class table used by the validators (built once)
+const unsigned char* validatorCharClasses() {
+    static unsigned char classes[256];
+    static bool built = false;
+    if (!built) {
+        for (int c = 0; c < 256; ++c) {
+            unsigned char cls = 0;
+            if (c >= '0' && c <= '9') cls |= CHAR_DIGIT | CHAR_WORD;
+            if (c >= 'A' && c <= 'Z') cls |= CHAR_UPPER | CHAR_WORD;
+            if (c >= 'a' && c <= 'z') cls |= CHAR_LOWER | CHAR_WORD;
+            if (c == '_') cls |= CHAR_WORD;
+            if (c != 0 && strchr("!@#$%^&*", c) != nullptr) cls |= CHAR_SPECIAL;
+            classes[c] = cls;
+        }
+        built = true;
+    }
+    return classes;
 }
 
-// Function to validate phone numbers
-bool isValidPhoneNumber(const string &phoneNumber) {
-// Check for formats like 01X-XXXXXXX or 01X-XXXXXXXX
-regex phonePattern("^(01[0-9]-[0-9]{7,8})$");
-return regex_match(trim(phoneNumber), phonePattern);
+// Function to find the bounds of a string without leading and trailing spaces (same rule as trim)
+void trimBounds(const string& str, size_t& first, size_t& last) {
+    first = str.find_first_not_of(' ');
+    if (first == string::npos) {
+        first = last = 0; // Empty or all spaces
+        return;
+    }
+    last = str.find_last_not_of(' ') + 1;
 }
 
-// Function to validate email addresses
-bool isValidEmail(const string& email) {
-    const regex pattern("(\\w+)(\\.|_)?(\\w*)@(\\w+)(\\.(\\w+))+");
-    return regex_match(trim(email), pattern);
+// Function to check that a range holds only characters of a class, with a length in range
+bool matchesClassRun(const string& str, size_t first, size_t last, unsigned char cls, size_t minLength, size_t maxLength) {
+    const unsigned char* classes = validatorCharClasses();
+    if (last - first < minLength || last - first > maxLength) {
+        return false;
+    }
+    for (size_t i = first; i < last; ++i) {
+        if (!(classes[static_cast<unsigned char>(str[i])] & cls)) {
+            return false;
+        }
+    }
+    return true;
 }
 
-// Function to validate passwords
-bool isValidPassword(const string& password) {
-    const regex pattern("(?=.*[a-z])(?=.*[A-Z])(?=.*\\d)(?=.*[!@#$%^&*])[a-zA-Z\\d!@#$%^&*]{8,}");
-    return regex_match(trim(password), pattern);
+// Function to validate customer names (letters, words separated by single spaces)
+bool isValidName(const string& name) {
+    const unsigned char* classes = validatorCharClasses();
+    size_t first, last;
+    trimBounds(name, first, last);
+    if (first == last) {
+        return false;
+    }
+    bool previousWasSpace = false;
+    for (size_t i = first; i < last; ++i) {
+        unsigned char c = name[i];
+        if (c == ' ') {
+            if (previousWasSpace) return false; // Only single spaces between words
+            previousWasSpace = true;
+        }
+        else if (classes[c] & (CHAR_UPPER | CHAR_LOWER)) {
+            previousWasSpace = false;
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
 }
 
-// Bank Account Number Validation (10-12 digits)
-bool isValidBankAccountNumber(const string &accountNumber) {
-    regex accountPattern("^[0-9]{10,12}$");  // Ensure it's a 10-12 digit number
-    return regex_match(trim(accountNumber), accountPattern);
+// Function to validate phone numbers
+bool isValidPhoneNumber(const string &phoneNumber) {
+    // Check for formats like 01X-XXXXXXX or 01X-XXXXXXXX
+    size_t first, last;
+    trimBounds(phoneNumber, first, last);
+    return last - first >= 11 && phoneNumber[first] == '0' && phoneNumber[first + 1] == '1' &&
+        matchesClassRun(phoneNumber, first + 2, first + 3, CHAR_DIGIT, 1, 1) &&
+        phoneNumber[first + 3] == '-' &&
+        matchesClassRun(phoneNumber, first + 4, last, CHAR_DIGIT, 7, 8);
 }
 
-// Credit Card Validation (16 digits) and CVV (3 digits)
+// Function to validate email addresses (word characters with at most one '.' before '@', dotted domain)
+bool isValidEmail(const string& email) {
+    const unsigned char* classes = validatorCharClasses();
+    size_t first, last;
+    trimBounds(email, first, last);
+    size_t at = email.find('@', first);
+    if (at == string::npos || at >= last || at == first || !(classes[static_cast<unsigned char>(email[first])] & CHAR_WORD)) {
+        return false;
+    }
+    // Local part: word characters and at most one '.'
+    int dots = 0;
+    for (size_t i = first; i < at; ++i) {
+        unsigned char c = email[i];
+        if (c == '.') {
+            if (++dots > 1) return false;
+        }
+        else if (!(classes[c] & CHAR_WORD)) {
+            return false;
+        }
+    }
+    // Domain: two or more non-empty runs of word characters separated by '.'
+    int segments = 0;
+    size_t segmentLength = 0;
+    for (size_t i = at + 1; i <= last; ++i) {
+        if (i == last || email[i] == '.') {
+            if (segmentLength == 0) return false;
+            segments++;
+            segmentLength = 0;
+        }
+        else if (classes[static_cast<unsigned char>(email[i])] & CHAR_WORD) {
+            segmentLength++;
+        }
+        else {
+            return false;
+        }
+    }
+    return segments >= 2;
+}
+
+// Function to validate passwords
+bool isValidPassword(const string& password) {
+    const unsigned char* classes = validatorCharClasses();
+    size_t first, last;
+    trimBounds(password, first, last);
+    if (last - first < 8) {
+        return false;
+    }
+    // Require a lowercase letter, an uppercase letter, a digit and a special character, and nothing else
+    unsigned char seen = 0;
+    for (size_t i = first; i < last; ++i) {
+        unsigned char cls = classes[static_cast<unsigned char>(password[i])];
+        if (!(cls & (CHAR_LOWER | CHAR_UPPER | CHAR_DIGIT | CHAR_SPECIAL))) {
+            return false;
+        }
+        seen |= cls;
+    }
+    unsigned char required = CHAR_LOWER | CHAR_UPPER | CHAR_DIGIT | CHAR_SPECIAL;
+    return (seen & required) == required;
+}
+
+// Bank Account Number Validation (10-12 digits)
+bool isValidBankAccountNumber(const string &accountNumber) {
+    size_t first, last;
+    trimBounds(accountNumber, first, last);
+    return matchesClassRun(accountNumber, first, last, CHAR_DIGIT, 10, 12);  // Ensure it's a 10-12 digit number
+}
+
+// Credit Card Validation (16 digits) and CVV (3 digits)
 bool isValidCreditCard(const string &cardNumber, const string &cvv) {
-    regex cardPattern("^[0-9]{16}$");   // 16-digit card number
-    regex cvvPattern("^[0-9]{3}$");     // 3-digit CVV number
-    return regex_match(trim(cardNumber), cardPattern) && regex_match(trim(cvv), cvvPattern);
+    size_t cardFirst, cardLast, cvvFirst, cvvLast;
+    trimBounds(cardNumber, cardFirst, cardLast);
+    trimBounds(cvv, cvvFirst, cvvLast);
+    return matchesClassRun(cardNumber, cardFirst, cardLast, CHAR_DIGIT, 16, 16) &&  // 16-digit card number
+        matchesClassRun(cvv, cvvFirst, cvvLast, CHAR_DIGIT, 3, 3);                  // 3-digit CVV number
+}
+
+// Function to validate a batch of customer records, collecting the rows that fail
+ValidationSummary validateCustomerRecords(const vector<Customer>& customers) {
+    ValidationSummary summary;
+    summary.total = static_cast<int>(customers.size());
+    for (int i = 0; i < summary.total; ++i) {
+        const Customer& customer = customers[i];
+        if (isValidName(customer.name) && isValidPhoneNumber(customer.contact) &&
+            isValidEmail(customer.email) && isValidPassword(customer.password)) {
+            summary.valid++;
+        }
+        else {
+            summary.invalidRows.push_back(i + 1); // 1-based row numbers
+        }
+    }
+    return summary;
 }
 
 // Function to generate a 6-digit OTP (One Time Password)
@@ -1360,16 +3440,13 @@ bool verifyOTP(const string &generatedOTP) {
 }
 
 // Function for customer signup process
-void customerSignUp(Customer customers[], int &customerCount) {
-    const int MAX_CUSTOMERS = 100; // Maximum number of customers allowed
-    if (customerCount >= MAX_CUSTOMERS) { // Check if the maximum limit is reached
-        cout << RED << "Maximum number of customers reached!" << RESET << endl;
-        return; // Exit if limit is reached
-    }
+void customerSignUp(CustomerDirectory& directory) {
     Customer newCustomer; // Create a new Customer object
 
     cout << "\n=== Customer Signup ===" << endl;
     cout << "[Enter -999 to go back]\n" << endl;
+    bool isValid; // Result of validating the latest input
+
     // Loop to get a valid name from the user
     do {
         cout << "Enter your name: ";
@@ -1379,11 +3456,12 @@ void customerSignUp(Customer customers[], int &customerCount) {
             cout << YELLOW << "Returning to previous menu." << RESET << endl;
             return; // Exit if user chooses to go back
         }
-        if (!isValidName(newCustomer.name)) { // Validate the name
+        isValid = isValidName(newCustomer.name); // Validate the name
+        if (!isValid) {
             cout << RED <<  "\nName can only contain letters. Please try again.\n" << RESET;
             cin.clear(); // Clear input stream for new input
         }
-    } while (!isValidName(newCustomer.name)); // Repeat until valid name is entered
+    } while (!isValid); // Repeat until valid name is entered
 
     // Loop to get a valid contact number from the user
     do {
@@ -1393,10 +3471,11 @@ void customerSignUp(Customer customers[], int &customerCount) {
             cout << YELLOW << "Returning to previous menu." << RESET << endl;
             return; // Exit if user chooses to go back
         }
-        if(!isValidPhoneNumber(newCustomer.contact)) {  // Validate contact number
+        isValid = isValidPhoneNumber(newCustomer.contact);  // Validate contact number
+        if (!isValid) {
             cout << RED <<  "\nInvalid contact number format.\nExample of contact: 012-3456789\nPlease try again.\n" << RESET;
         }
-    } while (!isValidPhoneNumber(newCustomer.contact)); // Repeat until valid number is entered
+    } while (!isValid); // Repeat until valid number is entered
 
     bool isUniqueEmail; // Flag to check for unique email
 
@@ -1408,19 +3487,16 @@ void customerSignUp(Customer customers[], int &customerCount) {
             cout << YELLOW << "Returning to previous menu." << RESET << endl;
             return; // Exit if user chooses to go back
         }
-        isUniqueEmail = true; // Assume the email is unique
-        for (int i=0; i<customerCount; i++) { // Check against existing customers
-            if (trim(customers[i].email) == trim(newCustomer.email)) {
-                cout << RED << "\nThis email is already registered. Please try a different email.\n" << RESET;
-                isUniqueEmail = false; // Mark as not unique
-                break; // Exit loop as duplicate found
-            }
+        isUniqueEmail = findCustomerByEmail(directory, newCustomer.email) == -1; // Hash lookup against existing customers
+        if (!isUniqueEmail) {
+            cout << RED << "\nThis email is already registered. Please try a different email.\n" << RESET;
         }
-        if (!isValidEmail(newCustomer.email)) { // Validate email format
+        isValid = isValidEmail(newCustomer.email); // Validate email format
+        if (!isValid) {
             cout << RED << "\nInvalid email format. Please try again.\n " << RESET;
             isUniqueEmail = false;
         }
-    } while (!isValidEmail(newCustomer.email) || !isUniqueEmail);  // Validate email format
+    } while (!isValid || !isUniqueEmail);  // Repeat until a valid, unique email is entered
 
 
     // Loop to get a valid password from the user
@@ -1431,7 +3507,8 @@ void customerSignUp(Customer customers[], int &customerCount) {
             cout << YELLOW << "Returning to previous menu." << RESET << endl;
             return; // Exit if user chooses to go back
         }
-        if (!isValidPassword(trim(newCustomer.password))) { // Validate password format
+        isValid = isValidPassword(newCustomer.password); // Validate password format
+        if (!isValid) {
             cout << RED << "Invalid password format.\n"
                 << "Password should be:\n "
                 << "- least 8 characters long\n"
@@ -1439,18 +3516,15 @@ void customerSignUp(Customer customers[], int &customerCount) {
                 << "- one digit and one special character" << RESET << endl;
         }
     }
-     while (!isValidPassword(trim(newCustomer.password))); // Repeat until valid password is entered
+     while (!isValid); // Repeat until valid password is entered
 
-    // Save the new customer to the array and increment the customer count
-    customers[customerCount] = newCustomer;
-    customerCount++;
-
-    // Save updated customer list to file
-    saveCustomersToFile(customers, customerCount);
+    // Add the new customer to the directory and append them to the customers file
+    addCustomerToDirectory(directory, newCustomer);
+    saveCustomerToFile(newCustomer);
 }
 
 // Function for customer login process
-int customerLogin(Customer customers[], int customerCount) {
+int customerLogin(const CustomerDirectory& directory) {
     string email, password; // Function for customer login process
     cout << "\n=== Customer Login ===" << endl;
     cout << "[Enter -999 to go back]\n" << endl;
@@ -1469,21 +3543,20 @@ int customerLogin(Customer customers[], int customerCount) {
         return -1; // Exit if user chooses to go back
     }
 
-    // Loop to validate email and password against existing customers
-    for (int i = 0; i < customerCount; i++) {
-        if (customers[i].email == email && customers[i].password == password) { // Check for matching credentials
-            return i; // Return index of the logged-in customer
-        }
+    // Look the customer up by email and check the password
+    int index = findCustomerByEmail(directory, email);
+    if (index != -1 && directory.customers[index].password == password) { // Check for matching credentials
+        return index; // Return index of the logged-in customer
     }
     cout << RED << "Login failed. Please try again.\n" << RESET; // Inform user of failed login
     pauseAndClearInput(); // Pause and clear input
     return -1; // Return -1 if login failed
 }
 
-// Function to save customer data to a file.
-void saveCustomersToFile(Customer customers[], int customerCount) {
-    // Open the file in output mode
-    ofstream outFile("customers.txt", ios::out);
+// Function to append a newly signed-up customer to the customers file.
+void saveCustomerToFile(const Customer& customer) {
+    // Open the file in append mode so existing customers are not rewritten
+    ofstream outFile("customers.txt", ios::app);
 
     // Check if the file was successfully opened for writing
     if (!outFile) {
@@ -1491,13 +3564,11 @@ void saveCustomersToFile(Customer customers[], int customerCount) {
         return;
     }
 
-    // Loop through each customer and save their details 
-    for (int i = 0; i < customerCount; i++) {
-        outFile << customers[i].name << ","
-            << customers[i].contact << ","
-            << customers[i].email << ","
-            << customers[i].password << endl;
-    }
+    // Save the customer's details
+    outFile << customer.name << ","
+        << customer.contact << ","
+        << customer.email << ","
+        << customer.password << endl;
 
     // Close the file after writing
     outFile.close();
@@ -1505,8 +3576,7 @@ void saveCustomersToFile(Customer customers[], int customerCount) {
 }   
 
 // Function to load customer data from a file.
-void loadCustomersFromFile(Customer customers[], int& customerCount) {
-    const int MAX_CUSTOMERS = 100;
+void loadCustomersFromFile(CustomerDirectory& directory) {
     // Open the file in input mode
     ifstream inFile("customers.txt");
 
@@ -1517,73 +3587,112 @@ void loadCustomersFromFile(Customer customers[], int& customerCount) {
     }
 
     string line;
-    customerCount = 0;
 
     // Read each line, split the data by commas, and store the customer details
-    while (getline(inFile, line) && customerCount < MAX_CUSTOMERS) {
+    while (getline(inFile, line)) {
+        if (line.empty()) {
+            continue; // Skip empty lines
+        }
         stringstream ss(line); // For splitting the line
-        string name, email, contact, password;
+        Customer customer;
 
-        getline(ss, name, ',');
-        getline(ss, contact, ',');
-        getline(ss, email, ',');
-        getline(ss, password, ',');
+        getline(ss, customer.name, ',');
+        getline(ss, customer.contact, ',');
+        getline(ss, customer.email, ',');
+        getline(ss, customer.password, ',');
 
-        // Populate the customers array with the data
-        customers[customerCount].name = name;
-        customers[customerCount].email = email;
-        customers[customerCount].contact = contact;
-        customers[customerCount].password = password;
-
-        customerCount++;
+        addCustomerToDirectory(directory, customer);
     }
 
     // Close the file after reading
     inFile.close();
+
+    // Re-validate the loaded records in one pass, as the file may have been imported from another system
+    ValidationSummary summary = validateCustomerRecords(directory.customers);
+    if (!summary.invalidRows.empty()) {
+        cerr << YELLOW << "Warning: " << summary.invalidRows.size() << " of " << summary.total
+            << " customer records in customers.txt failed validation (first at record " << summary.invalidRows[0] << ")." << RESET << endl;
+    }
+}
+
+// Function to get the customer directory, loading customers.txt on first use only
+CustomerDirectory& getCustomerDirectory() {
+    static CustomerDirectory directory;
+    if (!directory.loaded) {
+        directory.loaded = true;
+        loadCustomersFromFile(directory);
+    }
+    return directory;
+}
+
+// Function to normalize an email for lookups (trimmed and lowercase)
+string normalizeEmail(const string& email) {
+    string normalized = trim(email);
+    for (char& c : normalized) {
+        c = tolower(static_cast<unsigned char>(c));
+    }
+    return normalized;
+}
+
+// Function to find a customer by email, -1 if no customer uses it
+int findCustomerByEmail(const CustomerDirectory& directory, const string& email) {
+    auto it = directory.byEmail.find(normalizeEmail(email));
+    return it == directory.byEmail.end() ? -1 : it->second;
+}
+
+// Function to add a customer to the directory, false if the email is already registered
+bool addCustomerToDirectory(CustomerDirectory& directory, const Customer& customer) {
+    string key = normalizeEmail(customer.email);
+    if (directory.byEmail.find(key) != directory.byEmail.end()) {
+        return false; // The first customer registered with an email keeps it
+    }
+    directory.byEmail[key] = static_cast<int>(directory.customers.size());
+    directory.customers.push_back(customer);
+    return true;
 }
 
 // Function to check and display an expert's schedule based on user input.
 void checkSchedule() {
-    int choice, week;
-
-    // Initialize the experts with names
-    Expert alice, bob, carol;
-    initializeExpert(alice, "Alice");
-    initializeExpert(bob, "Bob");
-    initializeExpert(carol, "Carol");
-    Expert experts[] = { alice, bob, carol };
+    int choice;
 
     // Display options for selecting an expert
-    cout << "Experts: " << endl;
-    cout << "+-----------+--------------------------------------------+" << endl;
-    cout << "| Option    | Description                                |" << endl;
-    cout << "+-----------+--------------------------------------------+" << endl;
-    cout << "| [1]       | Alice                                      |" << endl;
-    cout << "| [2]       | Bob                                        |" << endl;
-    cout << "| [3]       | Carol                                      |" << endl;
-    cout << "+-----------+--------------------------------------------+" << endl;
+    int expertCount = displayExpertTable();
 
     // Get the user's choice for expert
     cout << "Check schedule for: (-999 to go back)";
-    choice = getValidatedInput(1, 3);
+    choice = getValidatedInput(1, expertCount);
     if (choice == -999) {
         return;
     }
-    // Get the week number from the user
-    cout << "Enter week number (1-5): ";
-    week = getValidatedInput(1, 5);
-    if (week == -999) {
+    // Get the week from the user
+    int week = chooseWeek();
+    if (week == -1) {
         return; // Return to the previous menu if the user enters -999
     }
-    --week; // Adjust for zero-based index
 
     // Clear the screen and load/display the schedule for the selected expert and week
     clearScreen();
-    loadScheduleFromFile(experts[choice - 1], week);
-    displaySchedule(experts[choice - 1], week);
+    Expert expert = getExpert(choice - 1);
+    loadScheduleFromFile(expert, week);
+    displaySchedule(expert, week);
 
 }
 
+// Function to list every expert in the registry as numbered options; returns how many were listed
+int displayExpertTable() {
+    const vector<Expert>& experts = getExpertRegistry().experts;
+    cout << "Experts: " << endl;
+    cout << "+-----------+--------------------------------------------+" << endl;
+    cout << "| Option    | Description                                |" << endl;
+    cout << "+-----------+--------------------------------------------+" << endl;
+    for (size_t i = 0; i < experts.size(); ++i) {
+        cout << "| " << setw(9) << left << "[" + to_string(i + 1) + "]"
+            << " | " << setw(42) << left << experts[i].name << " |" << endl;
+    }
+    cout << "+-----------+--------------------------------------------+" << endl;
+    return static_cast<int>(experts.size());
+}
+
 // Function to display the customer menu and handle customer-related actions.
 void customerMenu(Customer& customer) {
     int choice;
@@ -1681,21 +3790,16 @@ string getPasswordInput() {
 }
 
 // Function to handle login for admin and experts
-bool adminExpertLogin(UserType& userType, string& userName) {
+bool adminExpertLogin(UserType& userType, int& expertId) {
     clearScreen();
     displayLogo();
 
     // Display prompt to go back to previous menu
     cout << "[Input -999 to go back]" << endl;
 
-    // Predefined user data
-    User alice = { "alice123", "Alice1234$", EXPERT };
-    User bob = { "bob123", "Bob1234$", EXPERT };
-    User carol = { "carol123", "Carol1234$", EXPERT };
+    // The admin account; expert accounts come from experts.txt
     User admin = { "admin123", "Admin1234$", ADMIN };
 
-    User users[] = { alice, bob, carol, admin };
-
     string username, password;
     // Prompt for username input
     cout << "\nEnter username: ";
@@ -1715,12 +3819,17 @@ bool adminExpertLogin(UserType& userType, string& userName) {
         return false;
     }
 
-    // Check if username and password match any predefined user
-    for (int i = 0; i < 4; i++) {
-        if (users[i].username == username && users[i].password == password) {
-            userType = users[i].type;  // Set user type (Admin/Expert)
-            // Remove last 3 characters from username
-            userName = users[i].username.substr(0, users[i].username.length() - 3);
+    // Check the admin account, then every expert with a login
+    if (admin.username == username && admin.password == password) {
+        userType = ADMIN;
+        expertId = -1;
+        return true;
+    }
+    const vector<ExpertProfile>& profiles = getExpertRegistry().profiles;
+    for (size_t id = 0; id < profiles.size(); id++) {
+        if (!profiles[id].username.empty() && profiles[id].username == username && profiles[id].password == password) {
+            userType = EXPERT;
+            expertId = static_cast<int>(id);
             return true;
         }
     }
@@ -1732,29 +3841,41 @@ bool adminExpertLogin(UserType& userType, string& userName) {
 }
 
 // Function to view schedule from expert menu
-void viewExpertSchedule(const string& expertName) {
-    Expert expert;
-    initializeExpert(expert, expertName);
-    for (int week = 0; week < 5; ++week) {
-        loadScheduleFromFile(expert, week);
-        cout << "Week " << week + 1 << " Schedule for " << expertName << ":\n";
+// Only the weeks of the booking horizon that have bookings are shown, found through the expert's booking index
+void viewExpertSchedule(int expertId) {
+    BookingStore& store = refreshBookingStore();
+    Expert expert = getExpert(expertId);
+    int firstWeek = firstBookableWeek();
+    vector<int> weeks;
+    for (int index : findBookingsByExpert(expert.name)) {
+        int week = store.receipts[index].week;
+        if (week >= firstWeek && week < firstWeek + CALENDAR_HORIZON_WEEKS) {
+            weeks.push_back(week);
+        }
+    }
+    sort(weeks.begin(), weeks.end());
+    weeks.erase(unique(weeks.begin(), weeks.end()), weeks.end());
+    int shownWeeks = 0;
+    for (int week : weeks) {
+        if (!readScheduleFile(expert, week)) {
+            continue; // Nothing booked this week
+        }
         bool hasBookings = false;
         // Check if there are any bookings for the week
-        for (int day = 0; day < 5; ++day) {
-            for (int slot = 0; slot < 8; ++slot) {
-                if (expert.schedule[day][slot].isBooked) {
-                    hasBookings = true;
-                    break;
-                }
-            }
-            if (hasBookings) break;
+        for (int day = 0; day < DAYS_IN_WEEK && !hasBookings; ++day) {
+            hasBookings = expert.bookedMask[day] != 0;
         }
-        // Display message if no bookings are found
         if (!hasBookings) {
-            cout << "No bookings for this week.\n";
+            continue;
         }
         // Display the week's schedule
+        cout << "Week " << week - firstWeek + 1 << " (" << formatWeekRange(week) << ") Schedule for " << expert.name << ":\n";
         displaySchedule(expert, week);
+        shownWeeks++;
+    }
+    // Display message if no bookings are found
+    if (shownWeeks == 0) {
+        cout << "No bookings for " << expert.name << " in the next " << CALENDAR_HORIZON_WEEKS << " weeks.\n";
     }
 }
 
@@ -1762,182 +3883,262 @@ void viewExpertSchedule(const string& expertName) {
 void initializeCleanSchedule(Expert& expert) {
     for (int day = 0; day < DAYS_IN_WEEK; ++day) {
         expert.hoursWorkedPerDay[day] = 0;
-        for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
-            expert.schedule[day][slot].isBooked = false;
-            expert.schedule[day][slot].timeRange = to_string(START_HOUR + slot) + ":00 - " + to_string(START_HOUR + slot + 1) + ":00";
-            expert.schedule[day][slot].type = CONSULTATION; // Default to consultation
-        }
+        expert.bookedMask[day] = 0;      // Nothing booked
+        expert.treatmentMask[day] = 0;   // Default to consultation
+        expert.unavailableMask[day] = 0;
     }
 }
 
 // Function to view schedule for all experts
 void viewAllSchedules() {
-    string expertNames[] = { "Alice", "Bob", "Carol" };
-    for (int i = 0; i < 3; i++) {
-        viewExpertSchedule(expertNames[i]);
+    int expertCount = static_cast<int>(getExpertRegistry().experts.size());
+    for (int id = 0; id < expertCount; id++) {
+        viewExpertSchedule(id);
         cout << "\nPress Enter to continue...";
         cin.ignore();
         cin.get(); // Wait for user input before continuing
     }
 }
 
-// Function to display list of customers with booking counts
-void displayCustomers(const Customer customers[], int customerCount, int bookingCounts[]) {
+// Function to display list of customers with booking counts, in the order given by a permutation of indexes
+void displayCustomers(const Customer customers[], const vector<int>& order, const int bookingCounts[]) {
+    static const string header =
+        "+-----+-----------------------------+---------------------------+-----------------+\n"
+        "| No  | Customer Name               | Email                     | Booking Count   |\n"
+        "+-----+-----------------------------+---------------------------+-----------------+\n";
     int choice;
-    cout << "+-----+-----------------------------+---------------------------+-----------------+" << endl;
-    cout << "| No  | Customer Name               | Email                     | Booking Count   |" << endl;
-    cout << "+-----+-----------------------------+---------------------------+-----------------+" << endl;
+    int customerCount = static_cast<int>(order.size());
+    string& screen = getScreenBuffer();
+    screen += header;
     for (int i = 0; i < customerCount; ++i) {
-        // Display customer details in a formatted table
-        cout << "| " << setw(2) << BLUE << "[" << i + 1 << "]" << RESET << " | " << setw(27) << customers[i].name
-            << " | " << setw(25) << customers[i].email
-            << " | " << setw(15) << bookingCounts[i] << " |" << endl;
+        const Customer& customer = customers[order[i]];
+        // Add customer details to the formatted table
+        screen += "| " BLUE "[" + to_string(i + 1) + "]" RESET " | ";
+        appendPadded(screen, customer.name, 27, false);
+        screen += " | ";
+        appendPadded(screen, customer.email, 25, false);
+        screen += " | ";
+        appendPadded(screen, to_string(bookingCounts[order[i]]), 15, false);
+        screen += " |\n";
+        if (screen.size() >= SCREEN_FLUSH_THRESHOLD) {
+            flushScreen(screen); // Very long lists go out in large pieces
+        }
     }
-    cout << "+----+------------------------------+---------------------------+-----------------+" << endl;
-    cout << "\nSelect a customer to view their information (-999 to go back): " << endl;
+    screen += "+----+------------------------------+---------------------------+-----------------+\n";
+    screen += "\nSelect a customer to view their information (-999 to go back): \n";
+    flushScreen(screen);
     choice = getValidatedInput(1, customerCount); // Get valid input
     if (choice == -999) {
         return; // Handle return to previous menu 
     }
 
-    displayCustomerDetails(customers[choice - 1]); // Display selected customer details
+    displayCustomerDetails(customers[order[choice - 1]]); // Display selected customer details
+}
+
+// Function to add one booking to every breakdown of a sales report
+void addToSalesReport(SalesReport& report, const Receipt& receipt) {
+    double amount = receipt.amountPaid;
+    report.totalRevenue += amount;
+    report.totalBookings++;
+
+    ReportBucket* buckets[5] = {
+        &report.byService[receipt.serviceId],
+        &report.byExpert[receipt.expertId],
+        &report.byDate[receipt.week >= 0 ? weekStartDay(receipt.week) + receipt.day : -1],
+        &report.bySessionType[receipt.sessionType],
+        &report.byPaymentMethod[receipt.paymentMethod]
+    };
+    for (ReportBucket* bucket : buckets) {
+        bucket->revenue += amount;
+        bucket->bookings++;
+    }
+}
+
+// Function to aggregate every active booking in the store in a single pass
+SalesReport aggregateSales(const BookingStore& store) {
+    SalesReport report;
+    for (size_t i = 0; i < store.receipts.size(); ++i) {
+        if (store.active[i]) {
+            addToSalesReport(report, store.receipts[i]);
+        }
+    }
+    return report;
+}
+
+// Function to display one breakdown of a sales report as a table, in the given row order
+void displayReportBreakdown(string& out, const string& title, const string& heading, const unordered_map<int, ReportBucket>& buckets, const vector<pair<int, string>>& rows) {
+    static const string border = "+-------------------------+----------+------------------+\n";
+    out += "\nRevenue by " + title + ":\n";
+    out += border;
+    out += "| ";
+    appendPadded(out, heading, 23, false);
+    out += " | Bookings | Revenue (RM)     |\n";
+    out += border;
+    for (const pair<int, string>& row : rows) {
+        auto it = buckets.find(row.first);
+        ReportBucket bucket = it != buckets.end() ? it->second : ReportBucket();
+        out += "| ";
+        appendPadded(out, row.second, 23, false);
+        out += " | ";
+        appendPadded(out, to_string(bucket.bookings), 8, true);
+        out += " | RM ";
+        appendMoney(out, bucket.revenue, 13);
+        out += " |\n";
+    }
+    out += border;
 }
 
 // Function to generate and display sales report
 void generateSalesReport() {
-    // Initialize receipts and load booking data
-    Receipt allReceipts[200];
-    int receiptCount = loadBookings(allReceipts);
-    string services[] = { "Facial", "Botox and Fillers", "Manicure" };
-    string experts[] = { "Alice", "Bob", "Carol" };
-    double facialRevenue = 0, botoxRevenue = 0, manicureRevenue = 0;
-    double aliceRevenue = 0, bobRevenue = 0, carolRevenue = 0;
-    double serviceRevenue[3] = { 0 };
-    double expertRevenue[3] = { 0 };
+    static const string tableHeader =
+        "\n+----------------------------------------------------------------------------------------------------------------------------------+\n"
+        "|                                                      Detailed Sales Report                                                       |\n"
+        "+----------------------------------------------------------------------------------------------------------------------------------+\n"
+        "| Booking #  | Date               | Time Slot         | Service Name        | Expert  | Customer Email          | Amount Paid (RM) |\n"
+        "+------------+--------------------+-------------------+---------------------+---------+-------------------------+------------------+\n";
+    static const string tableFooter =
+        "+------------+--------------------+-------------------+---------------------+---------+-------------------------+------------------+\n";
+    BookingStore& store = getBookingStore();
+    const vector<Receipt>& allReceipts = store.receipts;
 
     // Check if there are any bookings
-    if (receiptCount == 0) {
+    if (store.activeCount == 0) {
         cout << RED << "No bookings found. Unable to generate sales report." << RESET << endl;
         return;
     }
 
-    double totalRevenue = 0;
-    int totalBookings = 0;
-
-    // Display detailed sales report table
-    cout << "\n+-----------------------------------------------------------------------------------------------------------------------------+" << endl;
-    cout << "|                                                  Detailed Sales Report                                                      |" << endl;
-    cout << "+-----------------------------------------------------------------------------------------------------------------------------+" << endl;
-    cout << "| Booking #  | Date          | Time Slot         | Service Name        | Expert  | Customer Email          | Amount Paid (RM) |" << endl;
-    cout << "+------------+---------------+-------------------+---------------------+---------+-------------------------+------------------+" << endl;
+    SalesReport report;
+    string& screen = getScreenBuffer();
 
-    // Loop through each receipt to calculate totals and display details
-    for (int i = 0; i < receiptCount; ++i) {
-        // Calculate total revenue and bookings
-        totalRevenue += allReceipts[i].amountPaid;
-        totalBookings++;
+    // Detailed sales report table
+    screen += tableHeader;
 
-        // Calculate revenue by service
-        if (trim(allReceipts[i].serviceName) == "Facial") {
-            facialRevenue += allReceipts[i].amountPaid;
-        }
-        else if (trim(allReceipts[i].serviceName) == "Botox and Fillers") {
-            botoxRevenue += allReceipts[i].amountPaid;
+    // Stream the store once, aggregating totals while each receipt is added to the table
+    for (size_t i = 0; i < allReceipts.size(); ++i) {
+        if (!store.active[i]) {
+            continue; // Skip refunded bookings
         }
-        else if (trim(allReceipts[i].serviceName) == "Manicure") {
-            manicureRevenue += allReceipts[i].amountPaid;
+        const Receipt& receipt = allReceipts[i];
+        addToSalesReport(report, receipt);
+
+        screen += "| ";
+        appendPadded(screen, receipt.bookingNumber, 10, false);
+        screen += " | ";
+        appendPadded(screen, " " + bookingDateText(receipt), 18, false);
+        screen += " | ";
+        appendPadded(screen, receipt.timeSlot, 17, false);
+        screen += " | ";
+        appendPadded(screen, " " + getService(receipt.serviceId).name, 19, false); // Stored fields keep their separator space
+        screen += " | ";
+        appendPadded(screen, getExpertName(receipt.expertId), 7, false);
+        screen += " | ";
+        appendPadded(screen, receipt.customer.email, 23, false);
+        screen += " | RM ";
+        appendMoney(screen, receipt.amountPaid, 12);
+        screen += "  |\n";
+        if (screen.size() >= SCREEN_FLUSH_THRESHOLD) {
+            flushScreen(screen); // Large stores go out in large pieces rather than all at the end
         }
-
-        // Calculate revenue by expert
-        if (trim(allReceipts[i].expert.name) == "Alice") {
-            aliceRevenue += allReceipts[i].amountPaid;
-        }
-        else if (trim(allReceipts[i].expert.name) == "Bob") {
-            bobRevenue += allReceipts[i].amountPaid;
+    }
+    screen += tableFooter;
+
+    // Overall sales summary
+    screen += "\n+-----------------------------------+\n"
+        "|          Sales Summary            |\n"
+        "+-----------------------------------+\n"
+        "| Total Bookings: ";
+    appendPadded(screen, to_string(report.totalBookings), 17, true);
+    screen += " |\n| Total Revenue : RM ";
+    appendMoney(screen, report.totalRevenue, 14);
+    screen += " |\n+-----------------------------------+\n";
+
+    // Build the row order of each breakdown; services and experts come from the data, not a fixed list
+    vector<pair<int, string>> serviceRows, expertRows, dateRows, sessionRows, paymentRows;
+    const vector<Service>& services = getServiceCatalog().services;
+    for (const Service& service : services) {
+        if (service.offered || report.byService.count(service.id)) {
+            serviceRows.push_back({ service.id, service.name });
         }
-        else if (trim(allReceipts[i].expert.name) == "Carol") {
-            carolRevenue += allReceipts[i].amountPaid;
+    }
+    int expertCount = static_cast<int>(getExpertRegistry().experts.size());
+    for (int id = 0; id < expertCount; ++id) {
+        expertRows.push_back({ id, getExpertName(id) });
+    }
+    for (const pair<const int, ReportBucket>& entry : report.byDate) {
+        if (entry.first >= 0) {
+            dateRows.push_back({ entry.first, formatDate(entry.first) }); // Bookings of an unknown date get no row
         }
+    }
+    sort(dateRows.begin(), dateRows.end());
+    sessionRows.push_back({ TREATMENT, "Treatment" });
+    sessionRows.push_back({ CONSULTATION, "Consultation" });
+    for (int method = EWALLET; method < CANCELLED; ++method) {
+        paymentRows.push_back({ method, paymentMethodToString(static_cast<PaymentMethod>(method)) });
+    }
 
-        // Display each receipt's booking details in a table
-        cout << "| " << setw(10) << left << allReceipts[i].bookingNumber
-            << " | " << setw(13) << left << allReceipts[i].date + " July 2024"
-            << " | " << setw(17) << left << allReceipts[i].timeSlot
-            << " | " << setw(19) << left << allReceipts[i].serviceName
-            << " | " << setw(7) << left << allReceipts[i].expert.name
-            << " | " << setw(23) << left << allReceipts[i].customer.email
-            << " | RM " << setw(12) << right << fixed << setprecision(2) << allReceipts[i].amountPaid << "  |" << endl;
+    displayReportBreakdown(screen, "Service", "Service", report.byService, serviceRows);
+    displayReportBreakdown(screen, "Expert", "Expert", report.byExpert, expertRows);
+    displayReportBreakdown(screen, "Day", "Date", report.byDate, dateRows);
+    displayReportBreakdown(screen, "Session Type", "Session Type", report.bySessionType, sessionRows);
+    displayReportBreakdown(screen, "Payment Method", "Payment Method", report.byPaymentMethod, paymentRows);
+
+    // Collect the histogram bars: every service, then every expert
+    vector<double> allSales;
+    vector<string> barLabels;
+    for (const pair<int, string>& row : serviceRows) {
+        allSales.push_back(report.byService[row.first].revenue);
+        barLabels.push_back(row.second.substr(0, row.second.find(' '))); // First word keeps labels short
+    }
+    for (const pair<int, string>& row : expertRows) {
+        allSales.push_back(report.byExpert[row.first].revenue);
+        barLabels.push_back(row.second);
     }
-    // Display table footer
-    cout << "+------------+---------------+-------------------+---------------------+---------+-------------------------+------------------+" << endl;
-    
-    // Calculate service and expert revenues
-    double allSales[6] = { facialRevenue, botoxRevenue, manicureRevenue, aliceRevenue, bobRevenue, carolRevenue };
-    const char* serviceNames[6] = { "Facial", "Botox", "Manicure", "Alice", "Bob", "Carol"};
 
-    // Find maximum revenue for scaling histogram
+    // Find maximum revenue, then pick a 1-2-5 step that keeps the histogram at most ten rows tall
     double MAX = 0;
-    for (int i = 0; i < 6; i++) {
-        if (allSales[i] > MAX) {
-            MAX = allSales[i];
+    for (double sales : allSales) {
+        if (sales > MAX) {
+            MAX = sales;
         }
     }
-
-    int roundedMax = ((int)(MAX / 50) + 1) * 50;
-
-    // Display overall sales summary
-    cout << "\n+-----------------------------------+" << endl;
-    cout << "|          Sales Summary            |" << endl;
-    cout << "+-----------------------------------+" << endl;
-    cout << "| Total Bookings: " << setw(17) << totalBookings << " |" << endl;
-    cout << "| Total Revenue : RM " << setw(14) << fixed << setprecision(2) << totalRevenue << " |" << endl;
-    cout << "+-----------------------------------+" << endl;
-
-    // Display breakdown by service
-    cout << "\nRevenue by Service:\n";
-    cout << "+-------------------------+------------------+" << endl;
-    cout << "| Service                 | Revenue (RM)     |" << endl;
-    cout << "+-------------------------+------------------+" << endl;
-    cout << "| " << setw(23) << left << "Facial" << " | RM " << setw(13) << right << fixed << setprecision(2) << facialRevenue << " |" << endl;
-    cout << "| " << setw(23) << left << "Botox and Fillers" << " | RM " << setw(13) << right << fixed << setprecision(2) << botoxRevenue << " |" << endl;
-    cout << "| " << setw(23) << left << "Manicure" << " | RM " << setw(13) << right << fixed << setprecision(2) << manicureRevenue << " |" << endl;
-    cout << "+-------------------------+------------------+" << endl;
-
-    // Display breakdown by expert
-    cout << "\nRevenue by Expert:\n";
-    cout << "+-------------------------+------------------+" << endl;
-    cout << "| Expert                  | Revenue (RM)     |" << endl;
-    cout << "+-------------------------+------------------+" << endl;
-    cout << "| " << setw(23) << left << "Alice" << " | RM " << setw(13) << right << fixed << setprecision(2) << aliceRevenue << " |" << endl;
-    cout << "| " << setw(23) << left << "Bob" << " | RM " << setw(13) << right << fixed << setprecision(2) << bobRevenue << " |" << endl;
-    cout << "| " << setw(23) << left << "Carol" << " | RM " << setw(13) << right << fixed << setprecision(2) << carolRevenue << " |" << endl;
-    cout << "+-------------------------+------------------+" << endl;
-
-    // Display revenue breakdown in a histogram
-    printf("\n\t\tSALES REVENUE HISTOGRAM\n\n");
-
-    for (int yaxis = roundedMax; yaxis >= 0; yaxis -= 50) {
-        printf("%4d %c", yaxis, 179);
-        for (int i = 0; i < 6; i++) {
-            if (allSales[i] >= yaxis) {
-                printf("   %c%c%c%c", 178, 178, 178, 178);
-            }
-            else {
-                printf("       ");
-            }
+    long long step = 50;
+    while (MAX / step > 10) {
+        long long mantissa = step;
+        while (mantissa >= 10) {
+            mantissa /= 10;
         }
-        printf("\n");
+        step = mantissa == 2 ? step / 2 * 5 : step * 2; // 50 -> 100 -> 200 -> 500 -> 1000 ...
     }
-
-    printf("     %c", 192);
-    for (int i = 0; i < 50; i++) {
-        printf("%c", 196);
+    long long roundedMax = (static_cast<long long>(MAX / step) + 1) * step;
+    size_t axisWidth = to_string(roundedMax).length();
+
+    // Revenue breakdown as a histogram
+    const char AXIS = static_cast<char>(179), CORNER = static_cast<char>(192), RULE = static_cast<char>(196);
+    const string bar = string("  ") + string(4, static_cast<char>(178)) + "    ";
+    const string gap(10, ' ');
+    screen += "\n\t\tSALES REVENUE HISTOGRAM\n\n";
+
+    for (long long yaxis = roundedMax; yaxis >= 0; yaxis -= step) {
+        appendPadded(screen, to_string(yaxis), axisWidth, true);
+        screen += ' ';
+        screen += AXIS;
+        for (double sales : allSales) {
+            screen += sales >= yaxis ? bar : gap;
+        }
+        screen += '\n';
     }
-    printf("\n       ");
-    for (int i = 0; i < 6; i++) {
-        printf(" %s ", serviceNames[i]);
+
+    screen.append(axisWidth + 1, ' ');
+    screen += CORNER;
+    screen.append(allSales.size() * 10, RULE);
+    screen += '\n';
+    screen.append(axisWidth + 2, ' ');
+    for (const string& label : barLabels) {
+        screen += ' ';
+        appendPadded(screen, label.substr(0, 9), 9, false);
     }
-    printf("\n\n");
+    screen += "\n\n";
+    flushScreen(screen);
 }
 
 // Function to display details about a customer
@@ -1952,142 +4153,52 @@ void displayCustomerDetails(Customer customer) {
     // Note: For security reasons, customer password is not displayed
 }
 
-// Function to to count bookings for a specific customer with a specific expert
-int countCustomerExpertBookings(const Receipt receipts[], int receiptCount, const string& customerName, const string& expertName) {
-    int count = 0;
-    // Loop through all receipts to find matches for the customer and expert
-    for (int i = 0; i < receiptCount; ++i) {
-        // Check if both customer name and expert name match the receipt
-        if (trim(receipts[i].customer.name) == trim(customerName) && trim(receipts[i].expert.name) == trim(expertName)) {
-            ++count; // Increment count for each match found
-        }
-    }
-    return count; // Return the total count of bookings for that customer and expert
-}
-
-// Function to sort customers by the number of bookings with a specific expert
-void sortCustomersByExpertBookings(Customer customers[], int customerCount, const Receipt receipts[], int receiptCount, const string& expertName, int bookingCounts[]) {
-    // Sort customers using bubble sort based on the number of bookings with the given expert
-    for (int i = 0; i < customerCount - 1; ++i) {
-        for (int j = i + 1; j < customerCount; ++j) {
-            // Get the number of bookings for both customers
-            int bookingsA = countCustomerExpertBookings(receipts, receiptCount, customers[i].name, expertName);
-            int bookingsB = countCustomerExpertBookings(receipts, receiptCount, customers[j].name, expertName);
-
-            // Swap customers if bookingsA is less than bookingsB (i.e., sort in descending order)
-            if (bookingsA < bookingsB) {
-                // Swap customers[i] and customers[j]
-                Customer tempCustomer = customers[i];
-                customers[i] = customers[j];
-                customers[j] = tempCustomer;
-
-                // Swap corresponding booking counts
-                int tempCount = bookingCounts[i];
-                bookingCounts[i] = bookingCounts[j];
-                bookingCounts[j] = tempCount;
-            }
+// Function to sort customers by name alphabetically (case-insensitive, stable)
+void sortCustomersByName(const Customer customers[], vector<int>& order) {
+    // Case-fold each name once instead of on every comparison, keyed by position in order
+    // (order lists only some customer slots, e.g. those with an active booking)
+    vector<pair<string, int>> keyed(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        keyed[i].first = customers[order[i]].name;
+        keyed[i].second = order[i];
+        for (char& c : keyed[i].first) {
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
         }
     }
+    stable_sort(keyed.begin(), keyed.end(), [](const pair<string, int>& a, const pair<string, int>& b) {
+        return a.first < b.first;
+    });
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        order[i] = keyed[i].second;
+    }
 }
 
-// Function to sort customers by name alphabetically (case-insensitive)
-void sortCustomersByName(Customer customers[], int customerCount, int bookingCounts[]) {
-    for (int i = 0; i < customerCount - 1; ++i) {
-        int minIndex = i;
-        
-        for (int j = i + 1; j < customerCount; ++j) {
-            // Convert both customer names to lowercase for comparison
-            string currentName = customers[j].name;
-            string minName = customers[minIndex].name;
-
-            // Convert both strings to lowercase
-            for (int k = 0; k < currentName.length(); ++k) {
-                currentName[k] = tolower(currentName[k]);
-            }
-            for (int k = 0; k < minName.length(); ++k) {
-                minName[k] = tolower(minName[k]);
-            }
-
-            // Compare the lowercase names
-            if (currentName < minName) {
-                minIndex = j;
-            }
-        }
-
-        // Swap the found minimum element with the current element
-        if (minIndex != i) { 
-            // Swap customer objects
-            Customer tempCustomer = customers[i];
-            customers[i] = customers[minIndex];
-            customers[minIndex] = tempCustomer;
-
-            // Swap corresponding booking counts
-            int tempCount = bookingCounts[i];
-            bookingCounts[i] = bookingCounts[minIndex];
-            bookingCounts[minIndex] = tempCount;
-        }
-    }
-}
-
-// Function to sort customers by their total number of bookings
-void sortCustomersByTotalBookings(Customer customers[], int customerCount, int bookingCounts[]) {
-    // Bubble sort to sort customers by total bookings (in descending order)
-    for (int i = 0; i < customerCount - 1; i++) {
-        for (int j = 0; j < customerCount - i - 1; j++) {
-            // Compare adjacent elements and swap if the earlier element has fewer bookings
-            if (bookingCounts[j] < bookingCounts[j + 1]) {
-                // Swap customers[i] and customers[j]
-                Customer tempCustomer = customers[j];
-                customers[j] = customers[j + 1];
-                customers[j + 1] = tempCustomer;
-                // Swap corresponding booking counts
-                int tempCount = bookingCounts[j];
-                bookingCounts[j] = bookingCounts[j + 1];
-                bookingCounts[j + 1] = tempCount;
-            }
-        }
-    }
+// Function to sort customers by their number of bookings (descending, stable)
+void sortCustomersByBookings(vector<int>& order, const int bookingCounts[]) {
+    stable_sort(order.begin(), order.end(), [bookingCounts](int a, int b) {
+        return bookingCounts[a] > bookingCounts[b];
+    });
 }
 
 // Function to view customers based on expert or admin context
-void viewCustomers(string expertName = "") {
-    Receipt allReceipts[200]; // Array to hold all booking receipts
-    int receiptCount = loadBookings(allReceipts); // Load bookings into allReceipts
-    const int MAX_CUSTOMERS = 100; // Maximum number of customers that can be processed
-
-    // Capitalize the first letter of expert name for comparison
-    if (!expertName.empty()) {
-        expertName[0] = toupper(expertName[0]);
-    }
-
-    Customer customers[MAX_CUSTOMERS]; // Array to store unique customers
-    int bookingCounts[MAX_CUSTOMERS] = { 0 }; // Array to store booking counts for each customer
-    int customerCount = 0; // Keeps track of the number of unique customers
-
-    // Loop through all the receipts to filter and count customers
-    for (int i = 0; i < receiptCount; i++) {
-        // Skip receipts that do not match the expert name if one is provided
-        if (!expertName.empty() && trim(allReceipts[i].expert.name) != expertName) {
-            continue;
+void viewCustomers(int expertId = -1) {
+    BookingStore& store = refreshBookingStore(); // Booking store with counts kept up to date on every booking and refund
+
+    // Pick the counts to show: the expert's per-customer counts, or every customer's total
+    const Customer* customers = store.bookedCustomers.data();
+    const int* bookingCounts = store.customerBookingCounts.data();
+    int countLimit = static_cast<int>(store.customerBookingCounts.size());
+    if (expertId != -1) {
+        if (expertId >= static_cast<int>(store.expertCustomerCounts.size())) {
+            bookingCounts = nullptr;
+            countLimit = 0; // Expert has never been booked
         }
-
-        //Check if the customer already exists in the array
-        bool found = false;
-        for (int j = 0; j < customerCount; j++) {
-            if (customers[j].email == allReceipts[i].customer.email) {
-                bookingCounts[j]++; // Increment booking count fo rexisting customer
-                found = true;
-                break;
-            }
-        }
-
-        // If customer is new, add them to the array
-        if (!found && customerCount < MAX_CUSTOMERS) {
-            customers[customerCount] = allReceipts[i].customer;
-            bookingCounts[customerCount] = 1; // Start with 1 booking for the new customer
-            customerCount++;
+        else {
+            bookingCounts = store.expertCustomerCounts[expertId].data();
+            countLimit = static_cast<int>(store.expertCustomerCounts[expertId].size());
         }
     }
+
     // Display options for viewing or sorting customers
     int choice;
     clearScreen();
@@ -2104,30 +4215,42 @@ void viewCustomers(string expertName = "") {
         return; // Return to the previous menu if sentinel value (-999) is entered
     }
 
+    // List the slots of the customers that still hold a booking
+    vector<int> order;
+    if (expertId == -1) {
+        for (int i = 0; i < countLimit; i++) {
+            if (bookingCounts[i] > 0) {
+                order.push_back(i);
+            }
+        }
+    }
+    else {
+        // Only the customers of the expert's own bookings are visited
+        for (int index : findBookingsByExpert(getExpertName(expertId))) {
+            order.push_back(store.customerSlots[trim(store.receipts[index].customer.email)]);
+        }
+        sort(order.begin(), order.end());
+        order.erase(unique(order.begin(), order.end()), order.end());
+    }
+
     // Handle the user's choice
     switch (choice) {
     case 1:
-        displayCustomers(customers, customerCount, bookingCounts);  // Display unsorted customer data
-        break;
+        displayCustomers(customers, order, bookingCounts);  // Display unsorted customer data
         break;
     case 2:
-        sortCustomersByName(customers, customerCount, bookingCounts); // Sort by customer name
-        displayCustomers(customers, customerCount, bookingCounts); // Display sorted customers
+        sortCustomersByName(customers, order); // Sort by customer name
+        displayCustomers(customers, order, bookingCounts); // Display sorted customers
         break;
     case 3:
-        if (expertName.empty()) {
-            sortCustomersByTotalBookings(customers, customerCount, bookingCounts); // Sort by total bookings for admin
-        }
-        else { // Sort by expert-specific bookings
-            sortCustomersByExpertBookings(customers, customerCount, allReceipts, receiptCount, expertName, bookingCounts);
-        }
-        displayCustomers(customers, customerCount, bookingCounts); // Display sorted customers
+        sortCustomersByBookings(order, bookingCounts); // Sort by total bookings for admin, expert-specific bookings for experts
+        displayCustomers(customers, order, bookingCounts); // Display sorted customers
         break;
     }
 }
 
 // Function to display admin/expert-specific menu based on user type
-void adminExpertMenu(UserType& userType, string& userName) {
+void adminExpertMenu(UserType& userType, int& expertId) {
     int adminChoice, expertChoice;
 
     do {
@@ -2163,10 +4286,10 @@ void adminExpertMenu(UserType& userType, string& userName) {
 
             switch (expertChoice) {
             case 1:
-                viewExpertSchedule(userName); // Display the expert's own schedule
+                viewExpertSchedule(expertId); // Display the expert's own schedule
                 break;
             case 2:
-                viewCustomers(userName); // Display customers for the expert
+                viewCustomers(expertId); // Display customers for the expert
                 break;
             case 3: cout << "Returning to Main Menu\n"; 
                 clearScreen(); // Return to the main menu
@@ -2263,7 +4386,10 @@ void serviceDesc(Service service, Customer& customer) {
     cout << "===============================\n";
     cout << "\n" << service.name << "\n"; // Displays the service name
     cout << "Description: " << service.description << "\n"; // Displays service description
-    cout << "Treatment Price: RM" << fixed << setprecision(2) << service.price << "\n"; // Displays the price
+    cout << "Treatment Price: RM" << fixed << setprecision(2) << service.treatmentPrice
+        << " (" << service.treatmentDuration << " hour" << (service.treatmentDuration == 1 ? "" : "s") << ")\n"; // Displays the prices
+    cout << "Consultation Price: RM" << service.consultationPrice
+        << " (" << service.consultationDuration << " hour" << (service.consultationDuration == 1 ? "" : "s") << ")\n";
     cout << "===============================\n";
 
     // Asks the user if they want to book the service
@@ -2271,30 +4397,24 @@ void serviceDesc(Service service, Customer& customer) {
     char choice;
     cin >> choice;
     if (choice == 'Y' || choice == 'y') { // If 'Y' or 'y' is entered, proceed with booking
-        // Initialize experts Alice, Bob, and Carol
-        Expert alice, bob, carol;
-        initializeExpert(alice, "Alice");
-        initializeExpert(bob, "Bob");
-        initializeExpert(carol, "Carol");
-        Expert experts[] = { alice, bob, carol };
-
         // Displays a list of available experts and prompts the customer to choose one
+        const vector<Expert>& experts = getExpertRegistry().experts;
+        int firstAvailable = static_cast<int>(experts.size()) + 1; // Option after the last expert
         cout << "\n---------------------------\n";
         cout << "     Select Your Expert\n";
         cout << "---------------------------\n";
         cout << "We have the following beauty experts available:\n";
-        cout << "  [1]  Alice\n";
-        cout << "  [2]  Bob\n";
-        cout << "  [3]  Carol\n";
-        cout << "\nPlease select an expert by entering the number (1-3 or -999 to go back): ";
+        for (size_t i = 0; i < experts.size(); ++i) {
+            cout << "  [" << i + 1 << "]  " << experts[i].name << "\n";
+        }
+        cout << "  [" << firstAvailable << "]  First available expert\n";
+        cout << "\nPlease select an expert by entering the number (1-" << firstAvailable << " or -999 to go back): ";
         int expertChoice;
-        expertChoice = getValidatedInput(1, 3); // Ensures valid input between 1-3
+        expertChoice = getValidatedInput(1, firstAvailable); // Ensures a listed option is chosen
         if (expertChoice == -999) {
             return; // Returns to the main menu if -999 is entered
         }
 
-        Expert& selectedExpert = experts[expertChoice - 1]; // Assigns the chosen expert
-
         // Prompts the customer to choose between treatment or consultation session
         cout << "\n---------------------------\n";
         cout << "     Choose Session Type\n";
@@ -2319,9 +4439,144 @@ void serviceDesc(Service service, Customer& customer) {
             cout << RED <<  "Invalid choice. Exiting." << RESET;
             return;
         }
+        if (expertChoice == firstAvailable) {
+            bookFirstAvailable(service, sessionType, customer); // Book the earliest open slot with any expert
+            return;
+        }
         // Calls the makeBooking function to book the selected service with the chosen expert
-        makeBooking(selectedExpert, service, sessionType, customer);
+        Expert expert = getExpert(expertChoice - 1);
+        makeBooking(expert, service, sessionType, customer);
+    }
+}
+
+// Function to get the service catalog, loading services.txt on first use only
+ServiceCatalog& getServiceCatalog() {
+    static ServiceCatalog catalog;
+    static bool loaded = false;
+    if (!loaded) {
+        loaded = true; // Set first so internService can reach the catalog while loading
+        loadServicesFromFile(catalog);
+    }
+    return catalog;
+}
+
+// Function to load the offered services from services.txt, writing the original catalog if it is missing
+void loadServicesFromFile(ServiceCatalog& catalog) {
+    ifstream inFile(SERVICES_FILE);
+    if (!inFile) {
+        // First run: start with the original services and save them so the catalog can be edited
+        const struct { const char* name; double treatmentPrice; const char* description; } defaults[] = {
+            { "Facial", 150.00, "A rejuvenating facial treatment." },
+            { "Botox and Fillers", 250.00, "Cosmetic injections for wrinkle treatment." },
+            { "Manicure", 100.00, "A relaxing manicure sesion." },
+        };
+        for (const auto& entry : defaults) {
+            Service& service = catalog.services[internService(entry.name)];
+            service.description = entry.description;
+            service.treatmentPrice = entry.treatmentPrice;
+            offerService(catalog, service.id);
+        }
+        saveServicesToFile(catalog);
+        return;
+    }
+
+    string line;
+    // Read each line: name,treatment price,consultation price,treatment slots,consultation slots,description
+    while (getline(inFile, line)) {
+        if (trim(line).empty()) {
+            continue; // Skip empty lines
+        }
+        stringstream ss(line); // For splitting the line; the description may itself contain commas
+        string name, treatmentPrice, consultationPrice, treatmentSlots, consultationSlots, description;
+        getline(ss, name, ',');
+        getline(ss, treatmentPrice, ',');
+        getline(ss, consultationPrice, ',');
+        getline(ss, treatmentSlots, ',');
+        getline(ss, consultationSlots, ',');
+        getline(ss, description);
+        int treatmentDuration = atoi(treatmentSlots.c_str()), consultationDuration = atoi(consultationSlots.c_str());
+        if (trim(name).empty() || treatmentDuration < 1 || treatmentDuration > MAX_SESSION_SLOTS ||
+            consultationDuration < 1 || consultationDuration > MAX_SESSION_SLOTS) {
+            cerr << RED << "Skipping malformed service record: " << line << RESET << endl;
+            continue;
+        }
+        Service& service = catalog.services[internService(name)];
+        service.description = trim(description);
+        service.treatmentPrice = atof(treatmentPrice.c_str());
+        service.consultationPrice = atof(consultationPrice.c_str());
+        service.treatmentDuration = treatmentDuration;
+        service.consultationDuration = consultationDuration;
+        offerService(catalog, service.id);
+    }
+    inFile.close();
+}
+
+// Function to write the offered services to services.txt
+bool saveServicesToFile(const ServiceCatalog& catalog) {
+    ofstream outFile(SERVICES_FILE, ios::trunc);
+    if (!outFile) {
+        cerr << RED << "Error: Unable to write " << SERVICES_FILE << RESET << endl;
+        return false;
+    }
+    outFile << fixed << setprecision(2);
+    for (int serviceId : catalog.offeredIds) {
+        const Service& service = catalog.services[serviceId];
+        outFile << service.name << "," << service.treatmentPrice << "," << service.consultationPrice << ","
+            << service.treatmentDuration << "," << service.consultationDuration << "," << service.description << "\n";
+    }
+    return static_cast<bool>(outFile);
+}
+
+// Function to get the ID of a service, adding it to the catalog (not offered) if bookings name a service it lacks
+int internService(const string& name) {
+    ServiceCatalog& catalog = getServiceCatalog();
+    string key = trim(name);
+    auto it = catalog.idsByName.find(key);
+    if (it != catalog.idsByName.end()) {
+        return it->second;
     }
+    int id = static_cast<int>(catalog.services.size());
+    Service service;
+    service.id = id;
+    service.name = key;
+    catalog.services.push_back(service);
+    catalog.idsByName[key] = id;
+    return id;
+}
+
+// Function to find the ID of an offered service by name, -1 if it is not offered
+int findServiceId(const string& name) {
+    ServiceCatalog& catalog = getServiceCatalog();
+    auto it = catalog.idsByName.find(trim(name));
+    return it == catalog.idsByName.end() || !catalog.services[it->second].offered ? -1 : it->second;
+}
+
+// Function to get a service by ID
+const Service& getService(int serviceId) {
+    return getServiceCatalog().services[serviceId];
+}
+
+// Function to get the IDs of the services customers can book, in catalog order
+const vector<int>& getOfferedServices() {
+    return getServiceCatalog().offeredIds;
+}
+
+// Function to mark a catalog entry as offered to customers
+void offerService(ServiceCatalog& catalog, int serviceId) {
+    if (!catalog.services[serviceId].offered) {
+        catalog.services[serviceId].offered = true;
+        catalog.offeredIds.push_back(serviceId);
+    }
+}
+
+// Function to get the price of a session of a service
+double servicePrice(const Service& service, SessionType sessionType) {
+    return sessionType == TREATMENT ? service.treatmentPrice : service.consultationPrice;
+}
+
+// Function to get how many slots a session of a service takes
+int serviceDuration(const Service& service, SessionType sessionType) {
+    return sessionType == TREATMENT ? service.treatmentDuration : service.consultationDuration;
 }
 
 // Displays available services and allows the customer to choose a service to book
@@ -2329,70 +4584,51 @@ void viewServices(Customer& customer) {
     clearScreen(); // Clears the screen
     displayLogo(); // Displays the application logo
 
-    // Predefined service details
-    Service facial = { "Facial", "A rejuvenating facial treatment.", 150.00 };
-    Service botox = { "Botox and Fillers", "Cosmetic injections for wrinkle treatment.", 250.00 };
-    Service manicure = { "Manicure", "A relaxing manicure sesion.", 100.00 };
-
-    Service services[3] = { facial, botox, manicure }; // Array of services
-    int choice, service_count = 1;
+    const vector<int>& services = getOfferedServices(); // Services from the catalog
+    int serviceCount = static_cast<int>(services.size());
+    int choice;
     cout << "\nServices\n";
     cout << "+--------+------------------------------+" << endl;
     cout << "| " << setw(OPTION_WIDTH - 1) << "Option" << " | " << left << setw(DESC_WIDTH) << "Service Name" << " |" << endl;
     cout << "+--------+------------------------------+" << endl;
-    cout << "| " << setw(OPTION_WIDTH - 1) << "1" << " | " << setw(DESC_WIDTH) << "Facial" << " |" << endl;
-    cout << "| " << setw(OPTION_WIDTH - 1) << "2" << " | " << setw(DESC_WIDTH) << "Botox and Fillers" << " |" << endl;
-    cout << "| " << setw(OPTION_WIDTH - 1) << "3" << " | " << setw(DESC_WIDTH) << "Manicure" << " |" << endl;
+    for (int i = 0; i < serviceCount; ++i) {
+        cout << "| " << setw(OPTION_WIDTH - 1) << i + 1 << " | " << setw(DESC_WIDTH) << getService(services[i]).name << " |" << endl;
+    }
 
     cout << "+--------+------------------------------+" << endl;
     cout << "Enter your choice (-999 to go back): ";
 
-    choice = getValidatedInput(1, 3); // Ensures valid input between 1-3
+    choice = getValidatedInput(1, serviceCount); // Ensures a listed service is chosen
     if (choice == -999) { 
         return; // Returns to the main menu if -999 is entered
     }
 
     // Calls the serviceDesc function to display the chosen service details
-    serviceDesc(services[choice - 1], customer);
+    serviceDesc(getService(services[choice - 1]), customer);
 }
 
 // Displays the details of a specific expert
-void displayExpertDetails(Expert& expert) {
-    // Different output depending on which expert is selected
-    if (expert.name == "Alice") {
-        cout << "+--------------------------------------------------------+" << endl;
-        cout << "|                    Expert Details                      |" << endl;
-        cout << "+--------------------------------------------------------+" << endl;
-        cout << "| Name: Alice                                            |" << endl;
-        cout << "| Years of Experience: 5                                 |" << endl;
-        cout << "| Rating: 4.9/5                                          |" << endl;
-        cout << "+--------------------------------------------------------+" << endl;
-    }
-    else if (expert.name == "Bob") {
-        cout << "+--------------------------------------------------------+" << endl;
-        cout << "|                    Expert Details                      |" << endl;
-        cout << "+--------------------------------------------------------+" << endl;
-        cout << "| Name: Bob                                              |" << endl;
-        cout << "| Years of Experience: 2                                 |" << endl;
-        cout << "| Rating: 4.7/5                                          |" << endl;
-        cout << "+--------------------------------------------------------+" << endl;
-    }
-    else if (expert.name == "Carol") {
-        cout << "+--------------------------------------------------------+" << endl;
-        cout << "|                    Expert Details                      |" << endl;
-        cout << "+--------------------------------------------------------+" << endl;
-        cout << "| Name: Carol                                            |" << endl;
-        cout << "| Years of Experience: 8                                 |" << endl;
-        cout << "| Rating: 4.8/5                                          |" << endl;
-        cout << "+--------------------------------------------------------+" << endl;
-    }
+void displayExpertDetails(int expertId) {
+    const ExpertRegistry& registry = getExpertRegistry();
+    const ExpertProfile& profile = registry.profiles[expertId];
+    stringstream rating;
+    rating << fixed << setprecision(1) << profile.rating;
+
+    cout << "+--------------------------------------------------------+" << endl;
+    cout << "|                    Expert Details                      |" << endl;
+    cout << "+--------------------------------------------------------+" << endl;
+    cout << "| " << setw(54) << left << "Name: " + registry.experts[expertId].name << " |" << endl;
+    cout << "| " << setw(54) << left << "Years of Experience: " + to_string(profile.yearsOfExperience) << " |" << endl;
+    cout << "| " << setw(54) << left << "Rating: " + rating.str() + "/5" << " |" << endl;
+    cout << "+--------------------------------------------------------+" << endl;
+
     // Asks the customer if they want to view the expert's schedule
     char viewSchedule;
     cout << "Do you want to view this expert's schedule? (Enter Y or any other key ): " << endl;
     cin >> viewSchedule;
 
     if (tolower(viewSchedule) == 'y') {
-        viewExpertSchedule(expert.name); // Calls function to display the expert's schedule
+        viewExpertSchedule(expertId); // Calls function to display the expert's schedule
     }
 }
 
@@ -2401,50 +4637,36 @@ void viewExperts() {
     clearScreen(); // Clears the screen
     displayLogo(); // Displays the application logo
 
-    int choice, week;
-    Expert alice, bob, carol;
-    initializeExpert(alice, "Alice");
-    initializeExpert(bob, "Bob");
-    initializeExpert(carol, "Carol");
-    Expert experts[] = { alice, bob, carol };
-
     // Displays a list of experts
-    cout << "Experts: " << endl;
-    cout << "+-----------+--------------------------------------------+" << endl;
-    cout << "| Option    | Description                                |" << endl;
-    cout << "+-----------+--------------------------------------------+" << endl;
-    cout << "| [1]       | Alice                                      |" << endl;
-    cout << "| [2]       | Bob                                        |" << endl;
-    cout << "| [3]       | Carol                                      |" << endl;
-    cout << "+-----------+--------------------------------------------+" << endl;
+    int expertCount = displayExpertTable();
     cout << "Select an expert to view their details (-999 to go back): ";
-    choice = getValidatedInput(1, 3); // Ensures valid input between 1-3
+    int choice = getValidatedInput(1, expertCount); // Ensures a listed expert is chosen
 
     if (choice == -999) {
         return; // Returns to the main menu if -999 is entered
     }
 
     // Calls the function to display the chosen expert's details
-    switch (choice) {
-    case 1:
-        displayExpertDetails(alice); break;
-    case 2:
-        displayExpertDetails(bob); break;
-    case 3:
-        displayExpertDetails(carol); break;
-    default:
-        cout << "No expert found." << endl;
-    }
+    displayExpertDetails(choice - 1);
 }
 
-// Clears the screen, cross-platform compatible
+// Clears the screen with ANSI escape sequences instead of a shell command
 void clearScreen() {
 #if defined(_WIN32) || defined(_WIN64)
-    system("pause"); // Pauses the screen on Windows
-    system("cls");
-#else
-    system("clear"); // Clears the screen on UNIX-based systems
+    // Let the Windows console interpret the escape sequences below
+    static bool virtualTerminal = [] {
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        return GetConsoleMode(console, &mode) && SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }();
+    (void)virtualTerminal;
+    cout << "Press any key to continue . . ." << flush; // Pauses the screen on Windows
+    _getch();
+    cout << "\n";
 #endif
+    string& screen = getScreenBuffer();
+    screen += "\033[H\033[2J\033[3J"; // Cursor home, clear the screen, clear the scrollback
+    flushScreen(screen);
 }
 
 // Pauses the program by prompting the user to press Enter, then clears the screen
@@ -2460,3 +4682,1040 @@ void pauseAndClearInput() {
     cin.ignore(1000, '\n');
     clearScreen();
 }
+
+// Set by SIGINT/SIGTERM to stop the booking server's event loop
+static volatile sig_atomic_t serverStopRequested = 0;
+
+// Signal handler asking the booking server to shut down
+void requestServerStop(int) {
+    serverStopRequested = 1;
+}
+
+// Function to split the arguments of a server request on '|'
+vector<string> splitRequestFields(const string& arguments) {
+    vector<string> fields;
+    size_t start = 0;
+    while (start <= arguments.size()) {
+        size_t end = arguments.find('|', start);
+        if (end == string::npos) {
+            end = arguments.size();
+        }
+        fields.push_back(trim(arguments.substr(start, end - start)));
+        start = end + 1;
+    }
+    return fields;
+}
+
+// Function to handle one request line from a server client and return the response
+// Requests are "VERB field|field|..."; responses are "OK ...", "ERR message", or "OK <n>" followed by n rows
+string handleServerRequest(ServerClient& client, const string& line) {
+    size_t space = line.find(' ');
+    string verb = line.substr(0, space);
+    for (char& c : verb) {
+        c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    }
+    vector<string> fields = splitRequestFields(space == string::npos ? "" : line.substr(space + 1));
+    CustomerDirectory& directory = getCustomerDirectory();
+
+    if (verb == "SIGNUP") { // SIGNUP name|contact|email|password
+        if (fields.size() != 4) return "ERR usage: SIGNUP name|contact|email|password\n";
+        Customer customer = { fields[0], fields[2], fields[1], fields[3] };
+        if (!isValidName(customer.name)) return "ERR invalid name\n";
+        if (!isValidPhoneNumber(customer.contact)) return "ERR invalid contact number\n";
+        if (!isValidEmail(customer.email)) return "ERR invalid email\n";
+        if (!isValidPassword(customer.password)) return "ERR invalid password\n";
+        if (!addCustomerToDirectory(directory, customer)) return "ERR email already registered\n";
+        saveCustomerToFile(customer);
+        client.customerIndex = findCustomerByEmail(directory, customer.email);
+        return "OK " + customer.name + "\n";
+    }
+    if (verb == "LOGIN") { // LOGIN email|password
+        if (fields.size() != 2) return "ERR usage: LOGIN email|password\n";
+        int index = findCustomerByEmail(directory, fields[0]);
+        if (index == -1 || directory.customers[index].password != fields[1]) return "ERR login failed\n";
+        client.customerIndex = index;
+        return "OK " + directory.customers[index].name + "\n";
+    }
+    if (verb == "AVAIL") { // AVAIL treatment|consultation[|count[|service]] -> rows of expert|YYYY-MM-DD|slot (1-based)
+        if (fields.empty() || fields.size() > 3) return "ERR usage: AVAIL treatment|consultation[|count[|service]]\n";
+        SessionType sessionType = tolower(fields[0][0]) == 't' ? TREATMENT : CONSULTATION;
+        int count = fields.size() >= 2 ? atoi(fields[1].c_str()) : NEXT_AVAILABLE_RESULTS;
+        int duration = sessionType == TREATMENT ? TREATMENT_SLOT_DURATION : CONSULTATION_SLOT_DURATION;
+        if (fields.size() == 3) {
+            int serviceId = findServiceId(fields[2]);
+            if (serviceId == -1) return "ERR unknown service\n";
+            duration = serviceDuration(getService(serviceId), sessionType);
+        }
+        vector<SlotCandidate> candidates = findNextAvailableSlots(duration, count > 0 ? count : NEXT_AVAILABLE_RESULTS);
+        string response = "OK " + to_string(candidates.size()) + "\n";
+        for (const SlotCandidate& candidate : candidates) {
+            response += getExpertName(candidate.expertId) + "|" + isoDate(weekStartDay(candidate.week) + candidate.day) + "|" +
+                to_string(candidate.slot + 1) + "\n";
+        }
+        return response;
+    }
+    if (verb == "BOOK") { // BOOK expert|YYYY-MM-DD|slot|service|treatment or consultation|ewallet, bank or card
+        if (client.customerIndex == -1) return "ERR login required\n";
+        if (fields.size() != 6) return "ERR usage: BOOK expert|date|slot|service|session|payment\n";
+        int expertId = findExpertId(fields[0]);
+        int date = parseIsoDate(fields[1]);
+        int week = calendarWeekOf(date), day = date - weekStartDay(week), slot = atoi(fields[2].c_str()) - 1;
+        int serviceId = findServiceId(fields[3]);
+        const Service* service = serviceId == -1 ? nullptr : &getService(serviceId);
+        SessionType sessionType = tolower(fields[4][0]) == 't' ? TREATMENT : CONSULTATION;
+        char payment = static_cast<char>(tolower(fields[5][0]));
+        PaymentMethod paymentMethod = payment == 'e' ? EWALLET : (payment == 'b' ? BANK_TRANSFER : (payment == 'c' ? CREDIT_CARD : CANCELLED));
+        if (expertId == -1) return "ERR unknown expert\n";
+        if (service == nullptr) return "ERR unknown service\n";
+        if (paymentMethod == CANCELLED) return "ERR unknown payment method\n";
+        if (date == -1 || !isBookableDate(week, day) || slot < 0 || slot >= MAX_SLOTS_PER_DAY) {
+            return "ERR no such slot\n";
+        }
+
+        // Hold and commit straight away; payment is taken by the client before it sends BOOK
+        Expert expert = getExpert(expertId);
+        loadScheduleFromFile(expert, week);
+        SlotHold hold;
+        if (!placeSlotHold(expert, week, day, slot, sessionType, serviceDuration(*service, sessionType), hold)) {
+            return "ERR slot not available\n";
+        }
+        string bookingNumber = generateBookingNumber();
+        if (bookingNumber.empty()) {
+            releaseSlotHold(hold);
+            return "ERR unable to issue a booking number\n";
+        }
+        if (!commitSlotHold(expert, hold)) {
+            return "ERR slot not available\n";
+        }
+        double price = servicePrice(*service, sessionType);
+        Receipt receipt = buildReceipt(bookingNumber, directory.customers[client.customerIndex], expert, week, day, slot,
+            *service, sessionType, paymentMethod, price);
+        if (!saveBooking(receipt)) {
+            updateExpertSchedules({ receipt }); // Free the committed slots again
+            return "ERR unable to save the booking\n";
+        }
+        generateReceiptFile(receipt, "receipts/receipt_" + bookingNumber + ".txt");
+        stringstream ss;
+        ss << "OK " << bookingNumber << "|" << receipt.date << "|" << receipt.timeSlot << "|" << fixed << setprecision(2) << price << "\n";
+        return ss.str();
+    }
+    if (verb == "REFUND") { // REFUND bookingNumber[|bookingNumber...], refunded together or not at all
+        if (client.customerIndex == -1) return "ERR login required\n";
+        if (fields.empty() || fields[0].empty()) return "ERR usage: REFUND bookingNumber[|bookingNumber...]\n";
+        vector<Receipt> receipts;
+        string refunded;
+        for (const string& bookingNumber : fields) {
+            const Receipt* booking = findBookingByNumber(bookingNumber);
+            if (booking == nullptr ||
+                normalizeEmail(booking->customer.email) != normalizeEmail(directory.customers[client.customerIndex].email)) {
+                return "ERR booking not found: " + bookingNumber + "\n";
+            }
+            receipts.push_back(*booking);
+            refunded += (refunded.empty() ? "" : "|") + trim(booking->bookingNumber);
+        }
+        if (processRefunds(receipts) == 0) {
+            return "ERR booking not found or not refunded\n";
+        }
+        return "OK " + refunded + "\n";
+    }
+    if (verb == "REPORT") { // REPORT -> TOTAL, SERVICE and EXPERT rows of name|bookings|revenue
+        SalesReport report = aggregateSales(getBookingStore());
+        vector<string> rows;
+        stringstream ss;
+        ss << fixed << setprecision(2);
+        ss << "TOTAL|all|" << report.totalBookings << "|" << report.totalRevenue;
+        rows.push_back(ss.str());
+        for (const Service& service : getServiceCatalog().services) {
+            if (!service.offered && !report.byService.count(service.id)) continue;
+            const ReportBucket& bucket = report.byService[service.id];
+            ss.str("");
+            ss << "SERVICE|" << service.name << "|" << bucket.bookings << "|" << bucket.revenue;
+            rows.push_back(ss.str());
+        }
+        int expertCount = static_cast<int>(getExpertRegistry().experts.size());
+        for (int id = 0; id < expertCount; ++id) {
+            auto it = report.byExpert.find(id);
+            if (it == report.byExpert.end()) continue;
+            ss.str("");
+            ss << "EXPERT|" << getExpertName(id) << "|" << it->second.bookings << "|" << it->second.revenue;
+            rows.push_back(ss.str());
+        }
+        string response = "OK " + to_string(rows.size()) + "\n";
+        for (const string& row : rows) {
+            response += row + "\n";
+        }
+        return response;
+    }
+    if (verb == "QUIT") {
+        client.closing = true;
+        return "OK bye\n";
+    }
+    return "ERR unknown request " + verb + "\n";
+}
+
+// Function to run the headless booking server on a Unix socket, serving every client from one poll() loop
+int runBookingServer(const string& socketPath) {
+#ifdef _WIN32
+    cerr << RED << "Server mode needs Unix domain sockets and is not available on Windows." << RESET << endl;
+    return 1;
+#else
+    signal(SIGPIPE, SIG_IGN); // A client hanging up must not kill the server
+    signal(SIGINT, requestServerStop);
+    signal(SIGTERM, requestServerStop);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str()); // Remove a socket left by an earlier run
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SERVER_BACKLOG) != 0) {
+        cerr << RED << "Error: Unable to listen on " << socketPath << ": " << strerror(errno) << RESET << endl;
+        if (listener >= 0) close(listener);
+        return 1;
+    }
+    fcntl(listener, F_SETFL, O_NONBLOCK);
+
+    // Load customers and bookings before the first request
+    getCustomerDirectory();
+    getBookingStore();
+    cout << "Booking server listening on " << socketPath << endl;
+
+    vector<ServerClient> clients;
+    vector<pollfd> pollSet;
+    while (!serverStopRequested) {
+        pollSet.clear();
+        pollSet.push_back({ listener, POLLIN, 0 });
+        for (const ServerClient& client : clients) {
+            pollSet.push_back({ client.fd, static_cast<short>(POLLIN | (client.output.empty() ? 0 : POLLOUT)), 0 });
+        }
+        if (poll(pollSet.data(), pollSet.size(), 1000) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        size_t polledClients = clients.size(); // Clients accepted below are polled from the next round
+        if (pollSet[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                ServerClient client;
+                client.fd = fd;
+                clients.push_back(client);
+            }
+        }
+
+        for (size_t i = 0; i < polledClients; ++i) {
+            ServerClient& client = clients[i];
+            short events = pollSet[i + 1].revents;
+            if (events & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[4096];
+                ssize_t received;
+                while ((received = read(client.fd, buffer, sizeof(buffer))) > 0) {
+                    client.input.append(buffer, static_cast<size_t>(received));
+                }
+                if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    client.closing = true; // Peer closed; answer what it already sent, then close
+                }
+
+                // Answer every complete request line in order
+                size_t lineEnd;
+                while ((lineEnd = client.input.find('\n')) != string::npos) {
+                    string request = client.input.substr(0, lineEnd);
+                    client.input.erase(0, lineEnd + 1);
+                    if (!request.empty() && request.back() == '\r') {
+                        request.pop_back();
+                    }
+                    if (!request.empty()) {
+                        client.output += handleServerRequest(client, request);
+                    }
+                }
+                if (client.input.size() > SERVER_MAX_REQUEST) {
+                    client.output += "ERR request too long\n";
+                    client.input.clear();
+                    client.closing = true;
+                }
+            }
+
+            // Write as much of the pending output as the socket takes
+            while (!client.output.empty()) {
+                ssize_t sent = write(client.fd, client.output.data(), client.output.size());
+                if (sent <= 0) {
+                    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                        client.output.clear();
+                        client.closing = true;
+                    }
+                    break;
+                }
+                client.output.erase(0, static_cast<size_t>(sent));
+            }
+        }
+
+        // Drop clients that are finished
+        for (size_t i = clients.size(); i-- > 0;) {
+            if (clients[i].closing && clients[i].output.empty()) {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + i);
+            }
+        }
+    }
+
+    for (const ServerClient& client : clients) {
+        close(client.fd);
+    }
+    close(listener);
+    unlink(socketPath.c_str());
+    cout << "Booking server stopped." << endl;
+    return 0;
+#endif
+}
+
+// Function to read dataset options given as key=value after --bench or --generate
+bool parseDatasetConfig(int argc, char* argv[], DatasetConfig& config) {
+    for (int i = 2; i < argc; ++i) {
+        string option = argv[i];
+        size_t equals = option.find('=');
+        string key = option.substr(0, equals);
+        string value = equals == string::npos ? "" : option.substr(equals + 1);
+        if (key == "dir" && !value.empty()) config.directory = value;
+        else if (key == "customers") config.customers = atoll(value.c_str());
+        else if (key == "experts") config.experts = atoi(value.c_str());
+        else if (key == "weeks") config.weeks = atoi(value.c_str());
+        else if (key == "bookings") config.bookings = atoll(value.c_str());
+        else if (key == "seed") config.seed = static_cast<unsigned int>(strtoul(value.c_str(), nullptr, 10));
+        else {
+            cerr << "Usage: latest " << argv[1] << " [customers=N] [experts=M] [weeks=W] [bookings=K] [seed=S] [dir=PATH]" << endl;
+            return false;
+        }
+    }
+    if (config.customers < 1 || config.experts < 0 || config.weeks < 1 || config.weeks > CALENDAR_HORIZON_WEEKS || config.bookings < 1) {
+        cerr << RED << "Dataset sizes must be positive and weeks at most " << CALENDAR_HORIZON_WEEKS << "." << RESET << endl;
+        return false;
+    }
+    return true;
+}
+
+// Function to switch into a directory for generated data, refusing one that already holds booking data
+bool enterEmptyDataDirectory(const string& directoryName) {
+    createDirectoryIfNotExists(directoryName);
+    if (CHDIR(directoryName.c_str()) != 0) {
+        cerr << RED << "Error: Unable to enter " << directoryName << RESET << endl;
+        return false;
+    }
+    if (ACCESS("bookings.txt", 0) == 0 || ACCESS(BOOKING_LOG_FILE, 0) == 0 || ACCESS("schedules", 0) == 0 ||
+        ACCESS("customers.txt", 0) == 0) {
+        cerr << RED << "Error: " << directoryName << " already holds booking data; use an empty directory." << RESET << endl;
+        return false;
+    }
+    return true;
+}
+
+// Function to build the synthetic customer with a given index; every field passes the sign-up validators
+Customer syntheticCustomer(long long index) {
+    static const char* syllables[16] = { "ka", "ri", "mo", "sa", "li", "na", "to", "ve", "da", "mi", "ro", "ze", "lu", "pe", "ha", "jo" };
+    string name;
+    for (int word = 0; word < 2; ++word) {
+        long long bits = index >> (12 * word);
+        string part = string(syllables[bits & 15]) + syllables[(bits >> 4) & 15] + syllables[(bits >> 8) & 15];
+        part[0] = static_cast<char>(toupper(part[0]));
+        name += (word == 0 ? "" : " ") + part;
+    }
+    char contact[16];
+    snprintf(contact, sizeof(contact), "01%d-%07lld", static_cast<int>(index % 10), index % 10000000);
+    return { name, "customer" + to_string(index) + "@example.com", contact, "Passw0rd!" };
+}
+
+// Function to print one benchmark row: throughput and p50/p99/p999 latency in microseconds
+void reportBenchmark(const string& name, vector<double>& samples, double seconds) {
+    if (samples.empty()) {
+        return;
+    }
+    sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double q) {
+        size_t index = static_cast<size_t>(q * samples.size());
+        return samples[index < samples.size() ? index : samples.size() - 1] / 1000.0;
+    };
+    cout << "| " << setw(24) << left << name
+        << " | " << setw(8) << right << samples.size()
+        << " | " << setw(12) << right << fixed << setprecision(0) << samples.size() / seconds
+        << " | " << setw(10) << right << setprecision(3) << percentile(0.50)
+        << " | " << setw(10) << right << percentile(0.99)
+        << " | " << setw(10) << right << percentile(0.999) << " |" << endl;
+}
+
+// Function to point stdout at the null device, returning the saved descriptor
+int silenceStdout() {
+    cout.flush();
+    fflush(stdout);
+    int saved = DUP(1);
+    FILE* sink = fopen(NULL_DEVICE, "w");
+    if (sink != nullptr) {
+        DUP2(fileno(sink), 1);
+        fclose(sink);
+    }
+    return saved;
+}
+
+// Function to restore stdout after silenceStdout
+void restoreStdout(int saved) {
+    cout.flush();
+    fflush(stdout);
+    if (saved >= 0) {
+        DUP2(saved, 1);
+        close(saved);
+    }
+}
+
+// Function to time the booking path against a synthetic dataset written to an empty directory
+int runBenchmark(const DatasetConfig& config) {
+    using Clock = chrono::steady_clock;
+    auto elapsedNs = [](Clock::time_point start) {
+        return static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count());
+    };
+
+    // Never run against live data: the benchmark writes bookings, schedules and receipts
+    if (!enterEmptyDataDirectory(config.directory)) {
+        return 1;
+    }
+
+    mt19937 random(config.seed);
+    cout << "Benchmark: " << config.customers << " customers, " << config.experts << " extra experts, "
+        << config.weeks << " weeks, " << config.bookings << " bookings, seed " << config.seed << endl;
+    cout << "+--------------------------+----------+--------------+------------+------------+------------+" << endl;
+    cout << "| Operation                |  Samples |      Ops/sec |   p50 (us) |   p99 (us) |  p999 (us) |" << endl;
+    cout << "+--------------------------+----------+--------------+------------+------------+------------+" << endl;
+
+    // Synthetic customers and experts
+    int quiet = silenceStdout();
+    CustomerDirectory& directory = getCustomerDirectory();
+    restoreStdout(quiet);
+    for (long long i = 0; i < config.customers; ++i) {
+        addCustomerToDirectory(directory, syntheticCustomer(i));
+    }
+    for (int i = 0; i < config.experts; ++i) {
+        registerExpert("Expert" + to_string(i + 1));
+    }
+    int expertCount = static_cast<int>(getExpertRegistry().experts.size());
+    const vector<int>& services = getOfferedServices();
+    vector<pair<int, int>> bookableDays; // (calendar week, day) pairs from today through the configured weeks, never empty
+    for (int week = firstBookableWeek(); week < firstBookableWeek() + config.weeks; ++week) {
+        for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+            if (isBookableDate(week, day)) {
+                bookableDays.push_back({ week, day });
+            }
+        }
+    }
+
+    // canBookSlot on random in-memory week states, timed in batches
+    {
+        vector<Expert> weeks(256);
+        for (Expert& expert : weeks) {
+            initializeCleanSchedule(expert);
+            for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+                expert.bookedMask[day] = static_cast<unsigned char>(random() & ALL_SLOTS_MASK);
+                expert.hoursWorkedPerDay[day] = random() % (MAX_WORK_HOURS + 1);
+            }
+        }
+        vector<double> samples;
+        volatile int open = 0;
+        Clock::time_point total = Clock::now();
+        for (int batch = 0; batch < 10000; ++batch) {
+            const Expert& expert = weeks[batch & 255];
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < BENCH_BATCH; ++i) {
+                open += canBookSlot(expert, i % DAYS_IN_WEEK, i % MAX_SLOTS_PER_DAY, (i & 1) ? TREATMENT_SLOT_DURATION : CONSULTATION_SLOT_DURATION);
+            }
+            samples.push_back(elapsedNs(start) / BENCH_BATCH);
+        }
+        reportBenchmark("canBookSlot", samples, elapsedNs(total) / 1e9 / BENCH_BATCH);
+    }
+
+    // Booking commit path: hold, commit, issue a number and save the booking
+    vector<string> booked;
+    {
+        int saved = silenceStdout();
+        vector<double> samples;
+        Clock::time_point total = Clock::now();
+        for (long long i = 0; i < config.bookings; ++i) {
+            const Customer& customer = directory.customers[random() % directory.customers.size()];
+            Expert expert = getExpert(static_cast<int>(random() % expertCount));
+            const pair<int, int>& date = bookableDays[random() % bookableDays.size()];
+            int week = date.first, day = date.second;
+            int slot = static_cast<int>(random() % MAX_SLOTS_PER_DAY);
+            SessionType sessionType = (random() & 1) ? TREATMENT : CONSULTATION;
+            const Service& service = getService(services[random() % services.size()]);
+
+            Clock::time_point start = Clock::now();
+            SlotHold hold;
+            if (placeSlotHold(expert, week, day, slot, sessionType, serviceDuration(service, sessionType), hold) && commitSlotHold(expert, hold)) {
+                double price = servicePrice(service, sessionType);
+                Receipt receipt = buildReceipt(generateBookingNumber(), customer, expert, week, day, slot, service, sessionType, CREDIT_CARD, price);
+                saveBooking(receipt);
+                booked.push_back(receipt.bookingNumber);
+            }
+            samples.push_back(elapsedNs(start));
+        }
+        double seconds = elapsedNs(total) / 1e9;
+        restoreStdout(saved);
+        reportBenchmark("book (commit path)", samples, seconds);
+    }
+    compactBookingLog(getBookingStore(), true); // Write bookings.txt so loadBookings has a snapshot to read
+
+    // loadBookings of the full snapshot
+    {
+        vector<double> samples;
+        Clock::time_point total = Clock::now();
+        for (int i = 0; i < 20; ++i) {
+            vector<Receipt> receipts;
+            Clock::time_point start = Clock::now();
+            loadBookings(receipts);
+            samples.push_back(elapsedNs(start));
+        }
+        reportBenchmark("loadBookings (" + to_string(getBookingStore().activeCount) + ")", samples, elapsedNs(total) / 1e9);
+    }
+
+    // loadScheduleFromFile of random expert-weeks
+    {
+        int saved = silenceStdout();
+        vector<double> samples;
+        Clock::time_point total = Clock::now();
+        for (int i = 0; i < 10000; ++i) {
+            Expert expert = getExpert(static_cast<int>(random() % expertCount));
+            int week = firstBookableWeek() + static_cast<int>(random() % config.weeks);
+            Clock::time_point start = Clock::now();
+            loadScheduleFromFile(expert, week);
+            samples.push_back(elapsedNs(start));
+        }
+        double seconds = elapsedNs(total) / 1e9;
+        restoreStdout(saved);
+        reportBenchmark("loadScheduleFromFile", samples, seconds);
+    }
+
+    // generateSalesReport, with its output discarded, and the aggregation on its own
+    {
+        int saved = silenceStdout();
+        vector<double> reportSamples, aggregateSamples;
+        Clock::time_point total = Clock::now();
+        for (int i = 0; i < 20; ++i) {
+            Clock::time_point start = Clock::now();
+            generateSalesReport();
+            reportSamples.push_back(elapsedNs(start));
+        }
+        double reportSeconds = elapsedNs(total) / 1e9;
+        total = Clock::now();
+        volatile double revenue = 0;
+        for (int i = 0; i < 20; ++i) {
+            Clock::time_point start = Clock::now();
+            revenue += aggregateSales(getBookingStore()).totalRevenue;
+            aggregateSamples.push_back(elapsedNs(start));
+        }
+        double aggregateSeconds = elapsedNs(total) / 1e9;
+        restoreStdout(saved);
+        reportBenchmark("generateSalesReport", reportSamples, reportSeconds);
+        reportBenchmark("aggregateSales", aggregateSamples, aggregateSeconds);
+    }
+
+    // processRefund of a random tenth of the bookings
+    {
+        shuffle(booked.begin(), booked.end(), random);
+        size_t refunds = (booked.size() + 9) / 10;
+        int saved = silenceStdout();
+        vector<double> samples;
+        Clock::time_point total = Clock::now();
+        for (size_t i = 0; i < refunds; ++i) {
+            Receipt receipt = *findBookingByNumber(booked[i]);
+            Clock::time_point start = Clock::now();
+            processRefund(receipt);
+            samples.push_back(elapsedNs(start));
+        }
+        double seconds = elapsedNs(total) / 1e9;
+        restoreStdout(saved);
+        reportBenchmark("processRefund", samples, seconds);
+
+        // processRefunds of the next tenth in one batch, timed per refund
+        vector<Receipt> batch;
+        for (size_t i = refunds; i < booked.size() && batch.size() < refunds; ++i) {
+            batch.push_back(*findBookingByNumber(booked[i]));
+        }
+        saved = silenceStdout();
+        Clock::time_point start = Clock::now();
+        processRefunds(batch);
+        double batchSeconds = elapsedNs(start) / 1e9;
+        restoreStdout(saved);
+        vector<double> batchSamples(batch.size(), batch.empty() ? 0.0 : batchSeconds * 1e9 / batch.size());
+        reportBenchmark("processRefunds (batch)", batchSamples, batchSeconds);
+    }
+
+    cout << "+--------------------------+----------+--------------+------------+------------+------------+" << endl;
+    cout << booked.size() << " of " << config.bookings << " booking attempts succeeded; data left in " << config.directory << endl;
+    return 0;
+}
+
+// Function to write a reproducible dataset in the formats the loaders read: customers.txt, experts.txt, bookings.txt,
+// binary schedule files that match the bookings, and a booking counter that continues after them
+int generateDataset(const DatasetConfig& config) {
+    if (config.experts < 1) {
+        cerr << RED << "The generator needs at least one expert." << RESET << endl;
+        return 1;
+    }
+    if (!enterEmptyDataDirectory(config.directory)) {
+        return 1;
+    }
+    mt19937_64 random(config.seed);
+    const size_t flushSize = 1 << 20; // Output is written in blocks of about 1 MiB
+    char line[512];
+
+    // Customers
+    FILE* customersFile = fopen("customers.txt", "wb");
+    if (customersFile == nullptr) {
+        cerr << RED << "Error: Unable to create customers.txt" << RESET << endl;
+        return 1;
+    }
+    string buffer;
+    buffer.reserve(flushSize + sizeof(line));
+    for (long long i = 0; i < config.customers; ++i) {
+        Customer customer = syntheticCustomer(i);
+        buffer += customer.name + "," + customer.contact + "," + customer.email + "," + customer.password + "\n";
+        if (buffer.size() >= flushSize) {
+            fwrite(buffer.data(), 1, buffer.size(), customersFile);
+            buffer.clear();
+        }
+    }
+    fwrite(buffer.data(), 1, buffer.size(), customersFile);
+    fclose(customersFile);
+    buffer.clear();
+
+    // Experts: the ones in experts.txt first, then Expert4, Expert5, ... with logins expert4 / Expert41234$, ...
+    ExpertRegistry& registry = getExpertRegistry();
+    for (int i = static_cast<int>(registry.experts.size()); i < config.experts; ++i) {
+        string name = "Expert" + to_string(i + 1);
+        registry.profiles[registerExpert(name)] = { "expert" + to_string(i + 1), name + "1234$", 1 + i % 10, 4.5 };
+    }
+    if (!saveExpertsToFile(registry)) {
+        return 1;
+    }
+    int expertCount = config.experts;
+
+    // Bookings, placed expert by expert with the same rules as an interactive booking
+    FILE* bookingsFile = fopen("bookings.txt", "wb");
+    if (bookingsFile == nullptr) {
+        cerr << RED << "Error: Unable to create bookings.txt" << RESET << endl;
+        return 1;
+    }
+    createDirectoryIfNotExists("schedules");
+    const vector<int>& services = getOfferedServices();
+    long long bookingNumber = 0;
+    int firstWeek = firstBookableWeek(); // Bookings start today, so the dataset is dated from the day it is generated
+    SparseSchedule schedule;         // The current expert's weeks; only weeks that get a booking take memory
+    vector<pair<int, int>> openDays; // (calendar week, day) pairs that can still take a session
+    for (int expertId = 0; expertId < expertCount; ++expertId) {
+        const string& expertName = getExpertName(expertId);
+        long long quota = config.bookings / expertCount + (expertId < config.bookings % expertCount ? 1 : 0);
+        Expert expert;
+        initializeExpert(expert, expertName);
+        schedule.weeks.clear();
+        openDays.clear();
+        for (int week = firstWeek; week < firstWeek + config.weeks; ++week) {
+            for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+                if (isBookableDate(week, day)) {
+                    openDays.push_back({ week, day });
+                }
+            }
+        }
+
+        for (long long placed = 0; placed < quota && !openDays.empty();) {
+            size_t pick = random() % openDays.size();
+            int week = openDays[pick].first, day = openDays[pick].second;
+            loadScheduleWeek(schedule, week, expert);
+
+            // Try the drawn session type, then the other, at a random valid start
+            const Service& service = getService(services[random() % services.size()]);
+            SessionType sessionType = (random() & 1) ? TREATMENT : CONSULTATION;
+            int starts[MAX_SLOTS_PER_DAY], startCount = 0;
+            for (int attempt = 0; attempt < 2 && startCount == 0; ++attempt) {
+                if (attempt == 1) {
+                    sessionType = sessionType == TREATMENT ? CONSULTATION : TREATMENT;
+                }
+                for (int slot = 0; slot < MAX_SLOTS_PER_DAY; ++slot) {
+                    if (canBookSlot(expert, day, slot, serviceDuration(service, sessionType))) {
+                        starts[startCount++] = slot;
+                    }
+                }
+            }
+            if (startCount == 0) {
+                openDays[pick] = openDays.back(); // Day is full
+                openDays.pop_back();
+                continue;
+            }
+            int slot = starts[random() % startCount];
+            int duration = serviceDuration(service, sessionType);
+            bookSlots(expert, day, slot, duration, sessionType);
+            if (expert.hoursWorkedPerDay[day] >= MAX_WORK_HOURS) {
+                unsigned char openSlots = ~expert.bookedMask[day] & ALL_SLOTS_MASK;
+                expert.unavailableMask[day] |= openSlots;
+                expert.treatmentMask[day] &= ~openSlots;
+            }
+            storeScheduleWeek(schedule, week, expert);
+
+            Customer customer = syntheticCustomer(static_cast<long long>(random() % config.customers)); // Rebuilt, not kept
+            double price = servicePrice(service, sessionType);
+            int length = snprintf(line, sizeof(line), "B%0*lld, %s, %s, %s, %s, %s, %d, %s, %d:00 - %d:00, %d, %g, %d, %d, %d, %d\n",
+                BOOKING_NUMBER_DIGITS, ++bookingNumber, customer.name.c_str(), customer.email.c_str(), customer.contact.c_str(),
+                expertName.c_str(), service.name.c_str(), static_cast<int>(sessionType), isoDate(weekStartDay(week) + day).c_str(),
+                START_HOUR + slot, START_HOUR + slot + duration, static_cast<int>(random() % CANCELLED), price,
+                week, day, slot, duration);
+            buffer.append(line, static_cast<size_t>(length));
+            if (buffer.size() >= flushSize) {
+                fwrite(buffer.data(), 1, buffer.size(), bookingsFile);
+                buffer.clear();
+            }
+            placed++;
+        }
+
+        // Only weeks with bookings hold a block, so only they get a schedule file; a missing file reads as a clean week
+        for (const pair<const int, ScheduleBlock>& week : schedule.weeks) {
+            ScheduleFileLayout layout;
+            memset(&layout, 0, sizeof(layout));
+            unpackScheduleBlock(week.second, expert);
+            writeScheduleLayout(expert, &layout);
+            FILE* scheduleFile = fopen(scheduleFileName(expertName, week.first).c_str(), "wb");
+            if (scheduleFile != nullptr) {
+                fwrite(&layout, sizeof(layout), 1, scheduleFile);
+                fclose(scheduleFile);
+            }
+        }
+    }
+    fwrite(buffer.data(), 1, buffer.size(), bookingsFile);
+    fclose(bookingsFile);
+
+    // Continue booking numbers after the generated ones
+    FILE* counterFile = fopen(BOOKING_COUNTER_FILE, "w");
+    if (counterFile != nullptr) {
+        fprintf(counterFile, "%lld", bookingNumber);
+        fclose(counterFile);
+    }
+
+    cout << "Generated " << config.customers << " customers, " << expertCount << " experts and " << bookingNumber
+        << " bookings in " << config.directory << " (seed " << config.seed << ")" << endl;
+    if (bookingNumber < config.bookings) {
+        cout << YELLOW << "Only " << bookingNumber << " of " << config.bookings << " bookings fit in " << config.weeks
+            << " weeks; add experts or weeks for more." << RESET << endl;
+    }
+    return 0;
+}
+
+// Function to parse one import row: customer name,email,contact,expert,date,start,service,session,payment[,amount]
+// The date is YYYY-MM-DD, the start is the hour the session begins (e.g. 14:00), the session is consultation or treatment,
+// the payment is card, ewallet or bank, and the amount defaults to the catalog price; false with the reason set if the row is invalid
+bool parseImportRow(const string& text, ImportRow& row) {
+    string fields[11];
+    int fieldCount = 0;
+    size_t start = 0;
+    while (fieldCount < 11) {
+        size_t comma = text.find(',', start);
+        fields[fieldCount++] = trim(text.substr(start, comma == string::npos ? string::npos : comma - start));
+        if (comma == string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    if (fieldCount < 9 || fieldCount > 10) {
+        row.error = "expected 9 or 10 columns";
+        return false;
+    }
+
+    Receipt& receipt = row.receipt;
+    receipt.customer = { fields[0], fields[1], fields[2], "" };
+    if (receipt.customer.name.empty() || receipt.customer.email.empty()) {
+        row.error = "missing customer name or email";
+        return false;
+    }
+    receipt.expertId = findExpertId(fields[3]);
+    if (receipt.expertId == -1) {
+        row.error = "unknown expert " + fields[3];
+        return false;
+    }
+    int date = parseIsoDate(fields[4]);
+    if (date == -1) {
+        row.error = "invalid date " + fields[4];
+        return false;
+    }
+    receipt.week = calendarWeekOf(date);
+    receipt.day = date - weekStartDay(receipt.week);
+    if (receipt.day >= DAYS_IN_WEEK) {
+        row.error = "not a weekday";
+        return false;
+    }
+    int hour = 0;
+    size_t digits = 0;
+    while (digits < fields[5].size() && isdigit(static_cast<unsigned char>(fields[5][digits])) && digits < 2) {
+        hour = hour * 10 + (fields[5][digits++] - '0');
+    }
+    // The hour may be followed by ":00" and nothing else
+    bool wholeHour = digits == fields[5].size() || (digits + 3 == fields[5].size() && fields[5].compare(digits, 3, ":00") == 0);
+    if (digits == 0 || !wholeHour) {
+        row.error = "invalid start time " + fields[5];
+        return false;
+    }
+    receipt.slot = hour - START_HOUR;
+    receipt.serviceId = findServiceId(fields[6]);
+    if (receipt.serviceId == -1) {
+        row.error = "unknown service " + fields[6];
+        return false;
+    }
+    char session = static_cast<char>(tolower(fields[7].empty() ? ' ' : fields[7][0]));
+    if (session != 'c' && session != 't') {
+        row.error = "unknown session type " + fields[7];
+        return false;
+    }
+    receipt.sessionType = session == 't' ? TREATMENT : CONSULTATION;
+    const Service& service = getService(receipt.serviceId);
+    receipt.duration = serviceDuration(service, receipt.sessionType);
+    if (receipt.slot < 0 || receipt.slot + receipt.duration > MAX_SLOTS_PER_DAY) {
+        row.error = "outside opening hours";
+        return false;
+    }
+    char payment = static_cast<char>(tolower(fields[8].empty() ? ' ' : fields[8][0]));
+    receipt.paymentMethod = payment == 'e' ? EWALLET : (payment == 'b' ? BANK_TRANSFER : (payment == 'c' ? CREDIT_CARD : CANCELLED));
+    if (receipt.paymentMethod == CANCELLED) {
+        row.error = "unknown payment method " + fields[8];
+        return false;
+    }
+    receipt.amountPaid = servicePrice(service, receipt.sessionType);
+    if (fieldCount == 10 && !fields[9].empty()) {
+        char* end = nullptr;
+        receipt.amountPaid = strtod(fields[9].c_str(), &end);
+        if (*end != '\0' || receipt.amountPaid < 0) {
+            row.error = "invalid amount " + fields[9];
+            return false;
+        }
+    }
+    receipt.date = isoDate(date);
+    receipt.timeSlot = to_string(START_HOUR + receipt.slot) + ":00 - " + to_string(START_HOUR + receipt.slot + receipt.duration) + ":00";
+    return true;
+}
+
+// Function to parse the rows between two line starts of an import file; returns how many lines the range holds
+// Each parsing thread runs this on its own range and rows, numbering lines from 1 within the range
+long long parseImportChunk(const string& data, size_t begin, size_t end, vector<ImportRow>& rows) {
+    long long line = 0;
+    size_t position = begin;
+    while (position < end) {
+        size_t lineEnd = data.find('\n', position);
+        if (lineEnd == string::npos || lineEnd > end) {
+            lineEnd = end;
+        }
+        line++;
+        size_t length = lineEnd - position;
+        if (length > 0 && data[lineEnd - 1] == '\r') {
+            length--;
+        }
+        if (length > 0 && data[position] != '#') { // Skip blank lines and comments
+            ImportRow row;
+            row.line = line;
+            row.offset = position;
+            row.length = length;
+            parseImportRow(data.substr(position, length), row);
+            rows.push_back(move(row));
+        }
+        position = lineEnd + 1;
+    }
+    return line;
+}
+
+// Function to import bookings from a CSV file in one batch
+// Rows are parsed in parallel, then each expert-week's rows are checked and booked under one lock of its schedule file;
+// the accepted bookings go to the booking log in one write, and rejected rows go to the rejects file with the reason
+int importBookings(const string& filename, const string& rejectsFilename) {
+    typedef chrono::steady_clock Clock;
+    Clock::time_point started = Clock::now();
+    ifstream in(filename, ios::binary);
+    if (!in.is_open()) {
+        cerr << RED << "Error: Unable to open " << filename << RESET << endl;
+        return 1;
+    }
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+
+    // Load the registries and bookings before any thread looks names up in them
+    getExpertRegistry();
+    getServiceCatalog();
+    BookingStore& store = getBookingStore();
+    Clock::time_point parseStarted = Clock::now();
+
+    // A first line whose date column is not a date is a header
+    size_t begin = 0;
+    long long firstLine = 1;
+    size_t firstLineEnd = data.find('\n');
+    size_t dateStart = 0;
+    for (int column = 0; column < 4 && dateStart != string::npos; ++column) {
+        dateStart = data.find(',', dateStart);
+        dateStart = dateStart == string::npos || dateStart > firstLineEnd ? string::npos : dateStart + 1;
+    }
+    if (dateStart != string::npos && parseIsoDate(data.substr(dateStart, data.find(',', dateStart) - dateStart)) == -1) {
+        begin = firstLineEnd == string::npos ? data.size() : firstLineEnd + 1;
+        firstLine = 2;
+    }
+
+    // Split the file into chunks at line ends, one per core, and parse them in parallel
+    size_t threadCount = max(1u, thread::hardware_concurrency());
+    size_t chunkCount = max<size_t>(1, min(threadCount, (data.size() - begin) / IMPORT_MIN_CHUNK_BYTES));
+    vector<size_t> bounds(1, begin);
+    for (size_t i = 1; i < chunkCount; ++i) {
+        size_t bound = data.find('\n', begin + (data.size() - begin) * i / chunkCount);
+        bound = bound == string::npos ? data.size() : bound + 1;
+        bounds.push_back(max(bound, bounds.back()));
+    }
+    bounds.push_back(data.size());
+    vector<vector<ImportRow>> chunkRows(chunkCount);
+    vector<long long> chunkLines(chunkCount, 0);
+    vector<thread> workers;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        workers.emplace_back([&, i]() { chunkLines[i] = parseImportChunk(data, bounds[i], bounds[i + 1], chunkRows[i]); });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    vector<ImportRow> rows;
+    long long lineBase = firstLine - 1;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        for (ImportRow& row : chunkRows[i]) {
+            row.line += lineBase;
+            rows.push_back(move(row));
+        }
+        lineBase += chunkLines[i];
+        vector<ImportRow>().swap(chunkRows[i]);
+    }
+    double parseMs = chrono::duration<double, milli>(Clock::now() - parseStarted).count();
+
+    // Reserve booking numbers for every parsed row with one counter update; rows rejected later leave gaps
+    long long parsed = 0;
+    for (const ImportRow& row : rows) {
+        parsed += row.error.empty();
+    }
+    long long nextId = 0;
+    if (parsed > 0 && !reserveBookingIds(BOOKING_COUNTER_FILE, parsed, nextId)) {
+        cerr << RED << "Error: Unable to reserve booking numbers; nothing was imported." << RESET << endl;
+        return 1;
+    }
+
+    // Group the rows by expert-week, keeping file order within each group
+    unordered_map<long long, vector<ImportRow*>> groups;
+    vector<long long> groupOrder;
+    for (ImportRow& row : rows) {
+        if (!row.error.empty()) {
+            continue;
+        }
+        long long key = expertWeekKey(row.receipt.expertId, row.receipt.week);
+        vector<ImportRow*>& group = groups[key];
+        if (group.empty()) {
+            groupOrder.push_back(key);
+        }
+        group.push_back(&row);
+    }
+
+    // Check and book each expert-week against its schedule as it is on disk, one locked write per week
+    // Slots closed for reaching the maximum hours are remembered per week, so a failed import can reopen them
+    unordered_map<long long, vector<unsigned char>> closedSlots;
+    for (long long key : groupOrder) {
+        vector<ImportRow*>& group = groups[key];
+        int week = group[0]->receipt.week;
+        Expert expert = getExpert(group[0]->receipt.expertId);
+        vector<unsigned char>& closed = closedSlots[key];
+        closed.assign(DAYS_IN_WEEK, 0);
+        bool booked = false;
+        bool checked = false;
+        updateScheduleFile(expert, week, [&](Expert& current, ScheduleFileLayout* layout) {
+            checked = true;
+            for (ImportRow* row : group) {
+                const Receipt& receipt = row->receipt;
+                if (!canBookSlot(current, receipt.day, receipt.slot, receipt.duration) ||
+                    (heldSlots(layout, receipt.day, 0) & slotRunMask(receipt.slot, receipt.duration)) != 0) {
+                    row->error = "slot not available";
+                    continue;
+                }
+                bookSlots(current, receipt.day, receipt.slot, receipt.duration, receipt.sessionType);
+                if (current.hoursWorkedPerDay[receipt.day] >= MAX_WORK_HOURS) {
+                    // If the expert reaches the max hours, mark remaining slots as unavailable
+                    unsigned char openSlots = ~current.bookedMask[receipt.day] & ALL_SLOTS_MASK;
+                    closed[receipt.day] |= openSlots & ~current.unavailableMask[receipt.day];
+                    current.unavailableMask[receipt.day] |= openSlots;
+                    current.treatmentMask[receipt.day] &= ~openSlots;
+                }
+                booked = true;
+            }
+            return booked;
+        });
+        if (!checked) {
+            for (ImportRow* row : group) {
+                row->error = "schedule file could not be written";
+            }
+        }
+    }
+
+    // Number the accepted rows in file order and log them in one write
+    vector<string> records;
+    string rejects;
+    long long imported = 0;
+    long long rejected = 0;
+    for (ImportRow& row : rows) {
+        if (!row.error.empty()) {
+            rejects += "# line " + to_string(row.line) + ": " + row.error + "\n";
+            rejects.append(data, row.offset, row.length);
+            rejects += "\n";
+            rejected++;
+            continue;
+        }
+        stringstream ss;
+        ss << "B" << setw(BOOKING_NUMBER_DIGITS) << setfill('0') << nextId++;
+        row.receipt.bookingNumber = ss.str();
+        records.push_back("B " + formatBookingRecord(row.receipt, ", "));
+        imported++;
+    }
+    if (!appendBookingLogRecords(records)) {
+        // Free the slots booked above again, so no schedule holds a booking that is not on record
+        for (long long key : groupOrder) {
+            vector<ImportRow*>& group = groups[key];
+            Expert expert = getExpert(group[0]->receipt.expertId);
+            const vector<unsigned char>& closed = closedSlots[key];
+            updateScheduleFile(expert, group[0]->receipt.week, [&](Expert& current, ScheduleFileLayout*) {
+                bool freed = false;
+                for (ImportRow* row : group) {
+                    if (row->error.empty()) {
+                        freeSlots(current, row->receipt.day, row->receipt.slot, row->receipt.duration);
+                        freed = true;
+                    }
+                }
+                for (int day = 0; day < DAYS_IN_WEEK; ++day) {
+                    current.unavailableMask[day] &= ~(closed[day] & ~current.bookedMask[day]);
+                }
+                return freed;
+            });
+        }
+        cerr << RED << "Error: The bookings could not be logged; nothing was imported." << RESET << endl;
+        return 1;
+    }
+    for (const ImportRow& row : rows) {
+        if (row.error.empty()) {
+            addBookingToStore(store, row.receipt);
+        }
+    }
+    compactBookingLog(store, true); // A large import is folded into the snapshot straight away
+
+    if (rejected > 0) {
+        ofstream out(rejectsFilename, ios::binary | ios::trunc);
+        out << rejects;
+    }
+    else {
+        remove(rejectsFilename.c_str()); // Do not leave the rejects of an earlier run behind
+    }
+    double totalMs = chrono::duration<double, milli>(Clock::now() - started).count();
+    cout << "Imported " << imported << " of " << rows.size() << " bookings from " << filename << " (parsed on " << chunkCount
+        << (chunkCount == 1 ? " thread" : " threads") << " in " << fixed << setprecision(1) << parseMs << " ms, "
+        << totalMs << " ms in all)." << endl;
+    if (rejected > 0) {
+        cout << YELLOW << rejected << " rejected rows written to " << rejectsFilename << RESET << endl;
+    }
+    return 0;
+}